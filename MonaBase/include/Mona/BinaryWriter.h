@@ -75,6 +75,8 @@ public:
 	
 	virtual BinaryWriter&	clear(UInt32 size = 0) { buffer().resize(size, true); return *this; }
 	BinaryWriter&	next(UInt32 count = 1);
+	// to allocate in one time the count next bytes to write
+	BinaryWriter&	reserve(UInt32 count) { Buffer& buffer(this->buffer()); buffer.reserve(buffer.size()+count); return *this; }
 	BinaryWriter&	clip(UInt32 offset) {buffer().clip(offset); return *this;}
 
 	const UInt8*	data() { return buffer().data(); }
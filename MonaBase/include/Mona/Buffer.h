@@ -25,17 +25,20 @@ This file is a part of Mona.
 
 namespace Mona {
 
+/// Memory is not initialized (content beyond what has been written is undefined)
 class Buffer : virtual NullableObject {
 public:
-	Buffer(UInt32 size = 0) : _offset(0),_capacity(size==0 ? 64 : size), _size(size) {_data = _buffer = new UInt8[_capacity]();}
-	Buffer(UInt8* buffer,UInt32 size) : _offset(0),_buffer(NULL),_data(buffer),_capacity(size), _size(size) {}
-	virtual ~Buffer() { if (_buffer) delete [] _buffer; }
+	Buffer(UInt32 size = 0);
+	Buffer(UInt8* buffer,UInt32 size) : _offset(0),_buffer(NULL),_external(false),_data(buffer),_capacity(size), _size(size) {}
+	virtual ~Buffer();
 
 	const UInt8		Buffer::operator[](UInt32 index) const { return _data[index >= _size ? (_size-1) : index]; }
 	UInt8&			Buffer::operator[](UInt32 index) { return _data[index >= _size ? (_size-1) : index]; }
 
 	void			clip(UInt32 offset);
 	bool			resize(UInt32 size, bool preserveContent);
+	// hint to allocate in one time when the final size is known, content is preserved
+	bool			reserve(UInt32 capacity);
 	void			clear();
 
 	UInt8*			data() { return _data; }
@@ -46,14 +49,44 @@ public:
 	
 	static Buffer Null;
 
+protected:
+	/// Buffer on a memory allocated by a subclass, which must override free() and call release() in its destructor.
+	/// This memory is counted by the subclass, not by the "buffers" memory counter (unlike the heap memory of a later resize)
+	Buffer(UInt8* buffer,UInt32 capacity,bool);
+
+	virtual void	free(UInt8* buffer) { delete [] buffer; }
+	/// release the memory (if owned)
+	void			release();
+
 private:
-	Buffer(bool,bool,bool) : NullableObject(true),_buffer(NULL),_data(NULL),_capacity(0), _size(0) {}
+	Buffer(bool,bool,bool) : NullableObject(true),_buffer(NULL),_external(false),_data(NULL),_capacity(0), _size(0) {}
+
+	void	reallocate(UInt32 capacity, UInt32 preserved);
 
 	UInt32  _offset;
 	UInt8*	_data;
 	UInt32	_size;
 	UInt32	_capacity;
 	UInt8*	_buffer;
+	bool	_external; // _buffer is the memory of the subclass
+};
+
+/// Buffer which starts on an inline storage of SIZE bytes, to avoid any allocation for a small transient buffer (on the stack),
+/// it moves to the heap if it grows beyond
+template<UInt32 SIZE = 64>
+class InlineBuffer : public Buffer {
+public:
+	InlineBuffer(UInt32 size = 0) : Buffer(_inline, SIZE, true) {
+		if (size > SIZE)
+			reserve(size);
+		resize(size, false);
+	}
+	virtual ~InlineBuffer() { release(); }
+
+private:
+	void	free(UInt8* buffer) { if (buffer != _inline) Buffer::free(buffer); }
+
+	UInt8	_inline[SIZE];
 };
 
 
@@ -37,9 +37,18 @@ public:
 
 	int receiveBytes(Exception& ex, void* buffer, int length, int flags = 0) { return Socket::receiveBytes(ex, buffer, length, flags); }
 	int receiveFrom(Exception& ex, void* buffer, int length, SocketAddress& address, int flags = 0) { return Socket::receiveFrom(ex, buffer, length, address, flags); }
+	int receive(Exception& ex, Buffer& buffer, UInt32 offset, SocketAddress& address) { return Socket::receive(ex, buffer, offset, &address); }
 
 	int sendBytes(Exception& ex, const void* buffer, int length, int flags = 0) { return Socket::sendBytes(ex, buffer, length, flags); }
 	int sendTo(Exception& ex, const void* buffer, int length, const SocketAddress& address, int flags = 0) { return Socket::sendTo(ex, buffer, length, address, flags); }
+
+	bool setBatch(UInt16 count) { return Socket::setBatch(count); }
+	UInt16 batch() const { return Socket::batch(); }
+	int receiveFrom(Exception& ex, Buffer** buffers, SocketAddress* addresses, int count, UInt16* segments = NULL) { return Socket::receiveFrom(ex, buffers, addresses, count, segments); }
+	bool setGSO(bool enable) { return Socket::setGSO(enable); }
+	bool gso() const { return Socket::gso(); }
+	bool setGRO(bool enable) { return Socket::setGRO(enable); }
+	bool gro() const { return Socket::gro(); }
 };
 
 
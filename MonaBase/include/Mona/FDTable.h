@@ -0,0 +1,130 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+#pragma once
+
+#include "Mona/Mona.h"
+#include "Mona/Net.h"
+#include <atomic>
+
+namespace Mona {
+
+/// Flat table indexed by socket descriptor (small dense integers on posix, handles multiple of 4 on windows).
+/// Slots are grouped in chunks allocated on demand and released only on destruction,
+/// so any thread can insert, find or erase a slot without lock (each slot is an atomic pointer)
+template<typename Type>
+class FDTable : virtual Object {
+public:
+	FDTable() : _chunks(new std::atomic<Slot*>[DIRECTORY_SIZE]), _size(0), _chunksUsed(0) {
+		for (UInt32 i = 0; i < DIRECTORY_SIZE; ++i)
+			_chunks[i].store(NULL, std::memory_order_relaxed);
+	}
+	virtual ~FDTable() {
+		for (UInt32 i = 0; i < DIRECTORY_SIZE; ++i)
+			delete [] _chunks[i].load(std::memory_order_relaxed);
+		delete [] _chunks;
+	}
+
+	UInt32	size() const { return _size; }
+
+	// Returns false if the descriptor is already set (or out of the table range)
+	bool insert(NET_SOCKET sockfd, Type* pValue) {
+		Slot* pSlot(slot(sockfd, true));
+		Type* pNull(NULL);
+		if (!pSlot || !pSlot->compare_exchange_strong(pNull, pValue))
+			return false;
+		++_size;
+		return true;
+	}
+
+	Type* find(NET_SOCKET sockfd) const {
+		Slot* pSlot(((FDTable*)this)->slot(sockfd, false));
+		return pSlot ? pSlot->load(std::memory_order_acquire) : NULL;
+	}
+
+	// Returns the value removed, NULL if nothing was set
+	Type* erase(NET_SOCKET sockfd) {
+		Slot* pSlot(slot(sockfd, false));
+		if (!pSlot)
+			return NULL;
+		Type* pValue(pSlot->exchange(NULL));
+		if (pValue)
+			--_size;
+		return pValue;
+	}
+
+	// Erases all the values, and calls onErase(sockfd, pValue) for each one
+	template<typename FunctionType>
+	void clear(const FunctionType& onErase) {
+		UInt32 chunks(_chunksUsed);
+		for (UInt32 i = 0; i < chunks; ++i) {
+			Slot* pChunk(_chunks[i].load(std::memory_order_acquire));
+			if (!pChunk)
+				continue;
+			for (UInt32 j = 0; j < CHUNK_SIZE; ++j) {
+				Type* pValue(pChunk[j].exchange(NULL));
+				if (!pValue)
+					continue;
+				--_size;
+				onErase((NET_SOCKET)(((i*CHUNK_SIZE) + j) << SHIFT), pValue);
+			}
+		}
+	}
+
+private:
+	typedef std::atomic<Type*> Slot;
+
+	enum {
+#if defined(_WIN32)
+		SHIFT = 2,
+#else
+		SHIFT = 0,
+#endif
+		CHUNK_SIZE = 4096,
+		DIRECTORY_SIZE = 16384 // 64M descriptors
+	};
+
+	Slot* slot(NET_SOCKET sockfd, bool create) {
+		size_t index((size_t)sockfd >> SHIFT);
+		size_t chunk(index / CHUNK_SIZE);
+		if (chunk >= DIRECTORY_SIZE)
+			return NULL;
+		Slot* pChunk(_chunks[chunk].load(std::memory_order_acquire));
+		if (!pChunk) {
+			if (!create)
+				return NULL;
+			Slot* pNew(new Slot[CHUNK_SIZE]);
+			for (UInt32 i = 0; i < CHUNK_SIZE; ++i)
+				pNew[i].store(NULL, std::memory_order_relaxed);
+			if (_chunks[chunk].compare_exchange_strong(pChunk, pNew))
+				pChunk = pNew;
+			else
+				delete [] pNew; // an other thread has created it in the meantime
+			UInt32 used(_chunksUsed);
+			while (used <= chunk && !_chunksUsed.compare_exchange_weak(used, (UInt32)chunk + 1));
+		}
+		return &pChunk[index % CHUNK_SIZE];
+	}
+
+	std::atomic<Slot*>*		_chunks;
+	std::atomic<UInt32>		_size;
+	std::atomic<UInt32>		_chunksUsed; // chunks index upper bound
+};
+
+
+} // namespace Mona
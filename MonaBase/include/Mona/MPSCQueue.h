@@ -0,0 +1,148 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include <atomic>
+#include <mutex>
+#include <deque>
+
+namespace Mona {
+
+/// Lock-free queue, multiple producers and one consumer (or several consumers with popShared).
+/// Each cell of the ring has a sequence number which tells to producers and consumer whether it is free or filled,
+/// so a producer just has to win the enqueue position (one CAS) and never waits the consumer.
+/// When the ring is full, push goes on in an unbounded overflow list (under lock) until the consumer empties it
+template<typename Type>
+class MPSCQueue : virtual Object {
+public:
+	// capacity is rounded up to a power of 2
+	MPSCQueue(UInt32 capacity=16384) : _enqueuePos(0), _dequeuePos(0), _overflowing(0) {
+		UInt32 size(2);
+		while (size < capacity)
+			size <<= 1;
+		_mask = size - 1;
+		_cells = new Cell[size];
+		for (UInt32 i = 0; i < size; ++i)
+			_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	virtual ~MPSCQueue() { delete [] _cells; }
+
+	// ring capacity
+	UInt32 capacity() const { return _mask + 1; }
+
+	// Can be called by any thread, returns false if the ring is full (or overflowed, to keep the order)
+	bool tryPush(const Type& value) {
+		if (_overflowing.load(std::memory_order_acquire))
+			return false;
+		Cell* pCell;
+		UInt32 pos = _enqueuePos.load(std::memory_order_relaxed);
+		for (;;) {
+			pCell = &_cells[pos & _mask];
+			Int32 diff = (Int32)(pCell->sequence.load(std::memory_order_acquire) - pos);
+			if (diff == 0) {
+				if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			} else if (diff < 0)
+				return false; // full
+			else
+				pos = _enqueuePos.load(std::memory_order_relaxed);
+		}
+		pCell->value = value;
+		pCell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Can be called by any thread, never blocked by the consumer: the value goes in the overflow list if the ring is full
+	void push(const Type& value) {
+		if (tryPush(value))
+			return;
+		std::lock_guard<std::mutex> lock(_mutexOverflow);
+		_overflow.emplace_back(value);
+		_overflowing.fetch_add(1, std::memory_order_release);
+	}
+
+	// Must be called always by the same thread (or under a lock)
+	bool pop(Type& value) {
+		UInt32 pos = _dequeuePos.load(std::memory_order_relaxed);
+		Cell& cell(_cells[pos & _mask]);
+		if ((Int32)(cell.sequence.load(std::memory_order_acquire) - (pos + 1)) < 0)
+			return popOverflow(pos, value); // empty ring
+		_dequeuePos.store(pos + 1, std::memory_order_relaxed);
+		release(cell, pos, value);
+		return true;
+	}
+
+	// Version of pop which can be called by several consumers at the same time (but never mixed with pop calls)
+	bool popShared(Type& value) {
+		Cell* pCell;
+		UInt32 pos = _dequeuePos.load(std::memory_order_relaxed);
+		for (;;) {
+			pCell = &_cells[pos & _mask];
+			Int32 diff = (Int32)(pCell->sequence.load(std::memory_order_acquire) - (pos + 1));
+			if (diff == 0) {
+				if (_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			} else if (diff < 0)
+				return popOverflow(pos, value); // empty ring
+			else
+				pos = _dequeuePos.load(std::memory_order_relaxed);
+		}
+		release(*pCell, pos, value);
+		return true;
+	}
+
+private:
+	struct Cell {
+		std::atomic<UInt32>	sequence;
+		Type				value;
+	};
+
+	void release(Cell& cell, UInt32 pos, Type& value) {
+		value = std::move(cell.value);
+		cell.value = Type();
+		cell.sequence.store(pos + _mask + 1, std::memory_order_release);
+	}
+
+	// the overflow list is read once the ring is empty, and if no push is in progress in the ring (older value)
+	bool popOverflow(UInt32 pos, Type& value) {
+		if (!_overflowing.load(std::memory_order_acquire) || _enqueuePos.load(std::memory_order_relaxed) != pos)
+			return false;
+		std::lock_guard<std::mutex> lock(_mutexOverflow);
+		if (_overflow.empty())
+			return false;
+		value = std::move(_overflow.front());
+		_overflow.pop_front();
+		_overflowing.fetch_sub(1, std::memory_order_release);
+		return true;
+	}
+
+	Cell*					_cells;
+	UInt32					_mask;
+	std::atomic<UInt32>		_enqueuePos;
+	std::atomic<UInt32>		_dequeuePos;
+
+	std::mutex				_mutexOverflow;
+	std::deque<Type>		_overflow;
+	std::atomic<UInt32>		_overflowing; // size of _overflow, the ring is not used while it's not empty
+};
+
+
+} // namespace Mona
@@ -0,0 +1,67 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include <atomic>
+#include <functional>
+
+namespace Mona {
+
+/// Accounting of the live memory by subsystem (bytes and objects), to know where the memory goes.
+/// Each subsystem declares a static Memory::Counter and updates it on its allocations
+class Memory : virtual Static {
+public:
+	/// Usually static, its constructor zeroes it: a static counter has to be declared before the static objects
+	/// of its translation unit which update it
+	class Counter : virtual Object {
+	public:
+		Counter(const char* name);
+		virtual ~Counter();
+
+		const char* const	name;
+
+		UInt64	bytes() const { Int64 bytes(_bytes.load(std::memory_order_relaxed)); return bytes > 0 ? bytes : 0; }
+		UInt32	objects() const { Int32 objects(_objects.load(std::memory_order_relaxed)); return objects > 0 ? objects : 0; }
+
+		// thread-safe, relaxed atomics just
+		void	add(Int64 bytes, Int32 objects = 0) {
+			_bytes.fetch_add(bytes, std::memory_order_relaxed);
+			if (objects)
+				_objects.fetch_add(objects, std::memory_order_relaxed);
+		}
+		void	set(UInt64 bytes, UInt32 objects) {
+			_bytes.store(bytes, std::memory_order_relaxed);
+			_objects.store(objects, std::memory_order_relaxed);
+		}
+
+	private:
+		std::atomic<Int64>	_bytes;
+		std::atomic<Int32>	_objects;
+	};
+
+	/// Calls function on each counter, in the registration order
+	static void	ForEach(const std::function<void(const Counter&)>& function);
+	/// Logs the counters
+	static void	Dump();
+};
+
+
+} // namespace Mona
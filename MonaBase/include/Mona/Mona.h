@@ -37,9 +37,11 @@ This file is a part of Mona.
 #define timegm _mkgmtime
 #define GMTIME(VALUE,RESULT) gmtime_s(&RESULT,&VALUE);
 #define LOCALTIME(VALUE,RESULT) localtime_s(&RESULT,&VALUE);
+#define THREAD_LOCAL __declspec(thread)
 #else
 #define GMTIME(VALUE,RESULT) gmtime_r(&VALUE,&RESULT)
 #define LOCALTIME(VALUE,RESULT) localtime_r(&VALUE,&RESULT)
+#define THREAD_LOCAL thread_local
 #endif
 
 ///// Disable some annoying warnings /////
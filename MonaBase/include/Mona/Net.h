@@ -31,6 +31,7 @@ This file is a part of Mona.
 #define NET_SOCKLEN			int
 #define NET_IOCTLREQUEST	int
 #define NET_CLOSESOCKET(s)  closesocket(s)
+#define NET_MSG_DONTWAIT	0 // sockets are already non-blocking with WSAAsyncSelect
 #define NET_EINTR           WSAEINTR
 #define NET_EACCES          WSAEACCES
 #define NET_EFAULT          WSAEFAULT
@@ -104,6 +105,7 @@ This file is a part of Mona.
 #define NET_IOCTLREQUEST     int
 #endif
 #define NET_CLOSESOCKET(s)  ::close(s)
+#define NET_MSG_DONTWAIT	MSG_DONTWAIT
 #define NET_EINTR           EINTR
 #define NET_EACCES          EACCES
 #define NET_EFAULT          EFAULT
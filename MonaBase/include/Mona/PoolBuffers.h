@@ -21,26 +21,136 @@ This file is a part of Mona.
 
 #include "Mona/Mona.h"
 #include "Mona/Buffer.h"
-#include <deque>
+#include <memory>
+#include <vector>
+#include <map>
 #include <mutex>
+#include <atomic>
+#include <thread>
 
 namespace Mona {
 
+/// Buffers are pooled by size classes (256B, 2KB, 16KB and 64KB), so a request gets always a buffer of the smallest class able to contain it.
+/// Each thread has its own cache of buffers by pool, under a lock which is never contended excepting by clear(),
+/// and which is refilled from (and flushed into) a shared pool by batch.
+/// Shared pools are trimmed on manage() to their high water mark, what has not been used since the previous call is released.
+/// Thread caches are trimmed the same way by their thread, on its first request following manage(),
+/// and flushed into the shared pool when their thread ends (Startable threads, see Startable::AddThreadEnd).
+/// Shared pools are split by NUMA node, a buffer released by a thread goes back to the threads running on the same node.
+/// Optionally, the buffers are carved from chunks of huge pages to save TLB misses (see setHugePages)
 class PoolBuffers : virtual Object {
 	friend class PoolBuffer;
 public:
-	PoolBuffers(UInt16 maximumCapacity = 32768) : _maximumCapacity(maximumCapacity) {}
-	virtual ~PoolBuffers() {clear();}
+	enum { CLASSES = 4 };
 
-	void clear();
+	struct Counters {
+		Counters() : capacity(0), hits(0), misses(0), available(0) {}
+		UInt32	capacity;	// capacity of the buffers of this class
+		UInt64	hits;		// requests served by a pooled buffer
+		UInt64	misses;		// requests which have required an allocation
+		UInt32	available;	// buffers pooled currently (shared pool + thread caches)
+	};
+
+	// buffers of a capacity greater than maximumCapacity are never pooled
+	PoolBuffers(UInt32 maximumCapacity = 65536);
+	virtual ~PoolBuffers();
+
+	// release all the pooled buffers (thread caches included) and reset the counters
+	void		clear();
+	// trim the shared pools, and the thread caches on their next request, to call periodically
+	void		manage();
+
+	UInt8		classes() const { return _count; }
+	Counters	counters(UInt8 index) const;
+	UInt64		hits() const;
+	UInt64		misses() const;
+	// requests greater than the last class, allocated without pooling
+	UInt64		unpooled() const { return _unpooled; }
+
+	// new buffers are carved from chunks of 2MB backed by huge pages (Linux only, explicit or transparent huge pages),
+	// to call before the first request, returns false if not supported (buffers stay allocated on the heap)
+	bool		setHugePages(bool enable);
+	bool		hugePages() const { return _hugePages; }
+	// memory reserved by the chunks
+	UInt64		chunksSize() const;
 
 private:
+	enum { NODES = 8, CACHE_SLOTS = 4 };
+
+	class ChunkBuffer;
+
+	// shared by the class and its chunk buffers, the chunks are freed with the last of them (a buffer can outlive its pool, see swap)
+	struct Chunks : virtual Object {
+		~Chunks();
+		std::mutex				mutex;
+		std::vector<void*>		chunks;
+		std::vector<UInt8*>		blocks; // free blocks of the chunks
+	};
+
+	struct Class : virtual Object {
+		Class();
+		UInt32					capacity;
+		UInt32					cacheMaximum; // maximum of buffers kept by a thread cache
+		std::mutex				mutex;
+		std::vector<Buffer*>	buffers[NODES]; // by NUMA node
+		UInt32					lowWater[NODES]; // minimum of buffers available since the last manage()
+		std::shared_ptr<Chunks>	chunks[NODES];
+		// counters of the caches released, protected by PoolBuffers::_mutex
+		UInt64					hits;
+		UInt64					misses;
+	};
+
+	struct Cache : virtual Object {
+		Cache(UInt32 generation);
+		~Cache();
+		void					clear();
+		// taken by its thread, and by clear() which is the only contention: a flag is cheaper than a mutex
+		void					lock() { while (_locked.test_and_set(std::memory_order_acquire)) std::this_thread::yield(); }
+		void					unlock() { _locked.clear(std::memory_order_release); }
+		UInt8					node; // NUMA node of the thread
+		std::vector<Buffer*>	buffers[CLASSES];
+		UInt32					generation; // manage() call of the last trim
+		UInt32					lowWater[CLASSES]; // minimum of buffers available since the last trim
+		// written under lock, read by counters() without it
+		std::atomic<UInt64>		hits[CLASSES];
+		std::atomic<UInt64>		misses[CLASSES];
+		std::atomic<UInt32>		available[CLASSES];
+	private:
+		std::atomic_flag		_locked;
+	};
+
 	Buffer*		beginBuffer(UInt32 size=0) const;
 	void		endBuffer(Buffer* pBuffer) const;
 
-	mutable std::deque<Buffer*>	_buffers;
-	mutable std::mutex			_mutex;
-	UInt16						_maximumCapacity;
+	// cache of the current thread for this pool, to lock before use
+	Cache&		cache() const;
+	void		trim(Cache& cache) const;
+	void		releaseCache() const;
+	bool		refill(Class& sizeClass, UInt8 node, std::vector<Buffer*>& buffers) const;
+	void		flush(Class& sizeClass, UInt8 node, std::vector<Buffer*>& buffers, UInt32 keep) const;
+	Buffer*		newBuffer(Class& sizeClass, UInt8 node) const;
+
+	static UInt8	CurrentNode();
+
+	const UInt32								_id;
+	std::atomic<UInt32>							_generation; // changes on manage()
+	UInt8										_count;
+	UInt32										_maximumCapacity;
+	mutable Class								_classes[CLASSES];
+	mutable std::mutex							_mutex;
+	mutable std::map<std::thread::id, Cache*>	_caches;
+	mutable std::atomic<UInt64>					_unpooled;
+	bool										_hugePages;
+	UInt32										_threadEnd; // releaseCache registered to Startable
+
+	// caches of the current thread for the last pools used (POD for THREAD_LOCAL), the others are found in _caches
+	struct CacheSlot {
+		UInt32	pool; // id of the pool, never reused
+		Cache*	pCache;
+	};
+	static std::atomic<UInt32>			_Ids;
+	static THREAD_LOCAL CacheSlot		_CacheSlots[CACHE_SLOTS];
+	static THREAD_LOCAL UInt8			_NextSlot;
 };
 
 
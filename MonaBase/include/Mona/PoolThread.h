@@ -20,37 +20,55 @@ This file is a part of Mona.
 #pragma once
 
 #include "Mona/Mona.h"
-#include "Mona/Startable.h"
 #include "Mona/WorkThread.h"
+#include "Mona/Exceptions.h"
 #include <memory>
 #include <deque>
+#include <vector>
+#include <functional>
+#include <mutex>
 
 
 namespace Mona {
 
-class PoolThread : private Startable, virtual Object {
-public:
-	PoolThread() : Startable("PoolThread" + std::to_string(++_Id)) {}
-	virtual ~PoolThread() {join();	}
+class PoolThreads;
 
-	void	join() { stop(); }
+/// Serial queue of jobs: its jobs are executed in order, one by one,
+/// by the first worker thread of PoolThreads available (not always the same)
+class PoolThread : virtual Object {
+	friend class PoolThreads;
+public:
+	PoolThread(PoolThreads& poolThreads) : _poolThreads(poolThreads), _scheduled(false) {}
 
 	template<typename WorkThreadType>
 	void push(Exception& ex,const std::shared_ptr<WorkThreadType>& pWork) {
-		std::lock_guard<std::mutex> lock(_mutex);
-		if (!running() && !start(ex))
-			return;
-		_jobs.emplace_back(pWork);
-		wakeUp();
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_jobs.emplace_back(pWork);
+			if (_scheduled)
+				return; // already in the worker queues
+			_scheduled = true;
+		}
+		schedule(ex);
 	}
+
+	// Defers a function until the PoolThread of the calling job has no more job to run (or at most DEFERRED_JOBS jobs later),
+	// allows to group some work (like datagram sending) of several jobs. Returns false if not called from a PoolThread job
+	static bool Defer(const std::function<void()>& function);
+
 private:
-	void	run(Exception& ex);
+	void	schedule(Exception& ex);
+	// run the jobs until the queue is empty, and then the deferred functions
+	void	run();
+	void	runDeferred();
 
+	PoolThreads&							_poolThreads;
 	std::mutex								_mutex;
 	std::deque<std::shared_ptr<WorkThread>>	_jobs;
-	
-	static UInt32							_Id;
+	bool									_scheduled;
+	std::vector<std::function<void()>>		_deferred; // accessed just by the thread running the jobs
 
+	static THREAD_LOCAL PoolThread*			_PCurrent; // PoolThread running on the current thread
 };
 
 
@@ -21,38 +21,69 @@ This file is a part of Mona.
 
 #include "Mona/Mona.h"
 #include "Mona/PoolThread.h"
-#include "Mona/Util.h"
-#include <deque>
+#include "Mona/Startable.h"
+#include "Mona/MPSCQueue.h"
+#include "Mona/WorkStealingDeque.h"
+#include <vector>
+#include <atomic>
 
 namespace Mona {
 
+/// Work-stealing scheduler: PoolThread are serial queues (to keep the order of jobs with the same affinity)
+/// which are run by a set of workers. Each worker has its own deque of PoolThread to run,
+/// and an idle worker steals in the deques of the others, so one long job delays just the jobs of its PoolThread
 class PoolThreads : virtual Object {
+	friend class PoolThread;
 public:
-	PoolThreads(UInt16 threadsAvailable=0) {
-		if (threadsAvailable == 0)
-			threadsAvailable = Util::ProcessorCount();
-		for(UInt16 i=0;i<threadsAvailable;++i) _threads.emplace_back(new PoolThread());
-	}
-	virtual ~PoolThreads() {
-		for(PoolThread* pThread : _threads) delete pThread;
-	}
+	PoolThreads(UInt16 threadsAvailable=0);
+	virtual ~PoolThreads();
 
-	void	join() { for(PoolThread* pThread : _threads) pThread->join(); }
-	UInt32	threadsAvailable() const { return _threads.size(); }
+	// wait the end of all the jobs queued, and stop workers
+	void	join();
+	UInt32	threadsAvailable() const { return _workers.size(); }
 
 	template<typename WorkThreadType>
     PoolThread* enqueue(Exception& ex, const std::shared_ptr<WorkThreadType>& pWork, PoolThread* pThread = NULL) {
-		if (!pThread) {
-			pThread = _threads.front();
-			_threads.pop_front();
-			_threads.emplace_back(pThread);
-		}
+		if (!pThread)
+			pThread = _threads[_next++ % _threads.size()];
 		pThread->push<WorkThreadType>(ex, pWork);
 		return pThread;
 	}
 
 private:
-	std::deque<PoolThread*>	_threads;
+	class Worker : private Startable, virtual Object {
+	public:
+		Worker(PoolThreads& poolThreads, UInt16 index);
+		virtual ~Worker() { stop(); }
+
+		bool	start(Exception& ex) { return Startable::start(ex); }
+		void	stop() { Startable::stop(); }
+		void	wakeUp() { Startable::wakeUp(); }
+
+		const UInt16						index;
+		WorkStealingDeque<PoolThread*>		threads;
+		std::atomic<bool>					idle;
+	private:
+		void	run(Exception& ex);
+
+		PoolThreads&	_poolThreads;
+	};
+
+	// starts the workers if not running
+	bool	start(Exception& ex);
+	bool	schedule(Exception& ex, PoolThread& thread);
+	// next PoolThread to run: in its deque, in the shared queue, or stolen to the others workers
+	bool	next(Worker& worker, PoolThread*& pThread);
+
+	std::vector<PoolThread*>		_threads;
+	std::atomic<UInt32>				_next;
+	std::vector<Worker*>			_workers;
+	MPSCQueue<PoolThread*>			_queue; // PoolThread scheduled by a non-worker thread
+
+	std::mutex						_mutex;
+	std::atomic<bool>				_running;
+
+	static THREAD_LOCAL Worker*		_PWorker; // worker of the current thread
 };
 
 
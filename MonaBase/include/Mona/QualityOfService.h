@@ -32,10 +32,14 @@ public:
 
 	void add(UInt32 ping,UInt32 size,UInt32 success=0,UInt32 lost=0);
 	void reset();
+	// state of the congestion control of the sender, if it has one
+	void setCongestion(UInt32 window,double rate);
 
 	const double		lostRate;
 	const double		byteRate;
 	const UInt32	latency;
+	const UInt32	congestionWindow; // bytes
+	const double		pacingRate; // bytes/s
 
 	static QualityOfService Null;
 private:
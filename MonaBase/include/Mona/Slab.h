@@ -0,0 +1,60 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include <mutex>
+#include <vector>
+
+namespace Mona {
+
+/// Pool of fixed size blocks, allocated by chunks and kept while the slab lives:
+/// a released block goes on a free list, so a steady flow of objects costs no malloc/free.
+/// Thread-safe, typically used by a class-specific operator new/delete
+class Slab : virtual Object {
+public:
+	Slab(UInt32 blockSize, UInt32 blocksByChunk = 64);
+	virtual ~Slab();
+
+	UInt32		blockSize() const { return _blockSize; }
+
+	void*		allocate();
+	void		release(void* pBlock);
+
+	// blocks allocated from the system
+	UInt32		blocks() const;
+	// blocks in use
+	UInt32		used() const;
+
+private:
+	struct Free {
+		Free*	pNext;
+	};
+
+	const UInt32			_blockSize;
+	const UInt32			_blocksByChunk;
+	mutable std::mutex		_mutex;
+	Free*					_pFree;
+	std::vector<UInt8*>		_chunks;
+	UInt32					_used;
+};
+
+
+} // namespace Mona
@@ -26,6 +26,7 @@ This file is a part of Mona.
 #include "Mona/Expirable.h"
 #include <memory>
 #include <deque>
+#include <atomic>
 
 namespace Mona {
 
@@ -48,6 +49,12 @@ public:
 		BOTH = 2
 	};
 
+	// Memory block of a gather sending
+	struct Part {
+		const UInt8*	data;
+		UInt32			size;
+	};
+
 	int		available(Exception& ex) { return ioctl(ex, FIONREAD, 0); }
 	
 	SocketAddress& address(Exception& ex, SocketAddress& address) const;
@@ -89,15 +96,32 @@ public:
 		if (!managed(ex))
 			return false;
 
-		// We can write immediatly if there are no queue packets to write,
-		// and if it remains some data to write (flush returns false)
 		std::lock_guard<std::mutex>	lock(_mutexAsync);
-		if (!_senders.empty() || !pSender->flush(ex, *this)) {
-            _senders.emplace_back(pSender);
-			manageWrite(ex);
+		if (_batch) {
+			// Batch mode, datagrams are queued and sent by group of _batch,
+			// or when the PoolThread of the caller has no more job to run (no more datagram coming, see flushBatch).
+			// Data are copied only if they stay queued after this call, the datagrams sent right now are never copied
+			queue(pSender);
+			if (_senders.size() < _batch && (_batchDeferred || (_batchDeferred = deferBatch()))) {
+				pSender->retain(poolBuffers());
+				return true;
+			}
+			if (!sendBatch(ex)) {
+				// socket buffer full, wait writable event
+				retainSenders();
+				manageWrite(ex);
+			}
 			return !ex;
 		}
-		return true;
+		// We can write immediatly if there are no queue packets to write,
+		// and if it remains some data to write (flush returns false)
+		if (!_senders.empty())
+			pSender->retain(poolBuffers());
+		else if (pSender->flush(ex, *this))
+			return true;
+		queue(pSender);
+		manageWrite(ex);
+		return !ex;
 	}
 
 	template<typename SocketSenderType>
@@ -114,14 +138,35 @@ public:
 	const PoolBuffers&	poolBuffers();
 	PoolThreads&		poolThreads();
 
+	// bytes queued which wait the socket to be writable
+	UInt32				queueing() const { return _queueing; }
+	// High-water mark of the queue, 0 means no limit: the socket is congested when queueing reaches it, and until queueing is down to its half.
+	// The queue is never refused (data of a stream can't be dropped by the socket), it's up to the writer to stop to write
+	void				setQueueMaximum(UInt32 bytes) { if (!(_queueMaximum = bytes)) _congested = false; }
+	UInt32				queueMaximum() const { return _queueMaximum; }
+	bool				congested() const { return _congested; }
+
 protected:
 	// Can be called by a separated thread!
 	virtual void			onError(const std::string& error) = 0;
+	// Can be called by a separated thread, when the socket becomes congested and when it's not congested anymore.
+	// The socket is locked during the call, don't send data from there
+	virtual void			onWriteBlocked() {}
+	virtual void			onWriteDrained() {}
 
 	void					close();
 	const SocketManager&	manager;
+
+	// true if the socket is polled in edge-triggered mode, onReadable has then to read until EAGAIN
+	bool					edgeTriggered() const { return _edgeTriggered; }
 	
 private:
+	// Returns true if onReadable can read until EAGAIN, what allows edge-triggered polling (see SocketManager::setEdgeTriggered)
+	virtual bool			drains() const { return false; }
+	// Returns true if onReadable (and what it calls) is thread-safe, the socket is then read by its reactor thread
+	// even with a SocketManager which posts its events to a handler thread (see SocketManager::Reactor)
+	virtual bool			readsInReactor() const { return false; }
+
 	// Creates a Socket
 	Socket(const SocketManager& manager, int type = SOCK_STREAM);
 
@@ -161,13 +206,40 @@ private:
 
 	int receiveBytes(Exception& ex, void* buffer, int length, int flags = 0);
 	int receiveFrom(Exception& ex, void* buffer, int length, SocketAddress& address, int flags = 0);
+	// Reads without blocking and without FIONREAD in buffer from offset until its size, what exceeds is read in a thread-local overflow
+	// and appended, then buffer is resized to offset+received bytes. Returns -1 if nothing is available (or on error), 0 on end of stream
+	int receive(Exception& ex, Buffer& buffer, UInt32 offset, SocketAddress* pAddress = NULL);
 
 
 	void shutdown(Exception& ex, ShutdownType type = BOTH);
 
 	int sendBytes(Exception& ex, const void* buffer, int length, int flags = 0);
+	// Gather sending (writev/WSASend) of the count parts in one call, returns the number of bytes sent
+	int sendBytes(Exception& ex, const Part* parts, UInt32 count, int flags = 0);
 	int sendTo(Exception& ex, const void* buffer, int length, const SocketAddress& address, int flags = 0);
 
+	// Batched datagram I/O with recvmmsg/sendmmsg (Linux only), count<2 disables it, returns false if unsupported
+	bool setBatch(UInt16 count);
+	UInt16 batch() const { return _batch; }
+	// Receives until count datagrams in one call, each buffer is filled until its size and resized to its datagram size (0 if truncated),
+	// with GRO segments gets the size of the datagrams coalesced in each buffer (0 if not coalesced)
+	int receiveFrom(Exception& ex, Buffer** buffers, SocketAddress* addresses, int count, UInt16* segments = NULL);
+	// Sends queued senders by group of _batch messages, returns false if the socket buffer is full
+	bool sendBatch(Exception& ex);
+	// Copies the data of the senders which stay queued (not owned by them), to send them later
+	void retainSenders();
+	// Registers flushBatch to the PoolThread of the caller, returns false if not called from a PoolThread
+	bool deferBatch();
+	// Sends the datagrams queued by the jobs of a PoolThread when it has no more job to run
+	void flushBatch();
+	// UDP offloads (Linux), must be called on a bound socket, returns false if unsupported by the kernel.
+	// GSO (UDP_SEGMENT) sends consecutive queued datagrams of a same size to a same destination in one message of the batch mode,
+	// GRO (UDP_GRO) allows the kernel to coalesce received datagrams of a same flow (see receiveFrom segments)
+	bool setGSO(bool enable);
+	bool gso() const { return _gso; }
+	bool setGRO(bool enable);
+	bool gro() const { return _gro; }
+
 	void setBroadcast(Exception& ex, bool flag) { setOption(ex, SOL_SOCKET, SO_BROADCAST, flag ? 1 : 0); }
 	bool getBroadcast(Exception& ex) { return getOption(ex, SOL_SOCKET, SO_BROADCAST) != 0; }
 
@@ -188,6 +260,10 @@ private:
 	// flush async sending
 	void    manageWrite(Exception& ex);
 	void	flushSenders(Exception& ex);
+	// add or remove a sender of the queue of senders, and count its bytes
+	void	queue(const std::shared_ptr<SocketSender>& pSender);
+	void	unqueue();
+	void	updateQueue(UInt32 added, UInt32 removed);
 
 	template<typename Type>
 	Type& getOption(Exception& ex, int level, int option, Type& value) {
@@ -212,10 +288,22 @@ private:
 	int		ioctl(Exception& ex,NET_IOCTLREQUEST request,int value);
 
 	std::unique_ptr<Socket>*					_ppSocket; // deleted by the socketmanager, and exists when managed!
+	UInt16										_reactor; // index of the socketmanager reactor which polls this socket
+	std::atomic<bool>							_readPending; // a read event is queued to the handler, and not handled yet
+	bool										_edgeTriggered; // registered one time for all with EPOLLET
+	bool										_readsInReactor; // read by the reactor thread, its events are not posted to the handler
+	std::atomic<UInt32>							_readEvents; // edge-triggered events received since the last handling
 
 	std::mutex									_mutexAsync;
 	bool										_writing;
+	UInt16										_batch; // datagrams by recvmmsg/sendmmsg call, 0 if disabled
+	bool										_batchDeferred; // flushBatch is registered to a PoolThread
+	bool										_gso;
+	bool										_gro;
 	std::deque<std::shared_ptr<SocketSender>>	_senders;
+	std::atomic<UInt32>							_queueing;
+	UInt32										_queueMaximum;
+	std::atomic<bool>							_congested;
 
 	std::mutex				_mutexManaged;
 	volatile bool			_managed;
@@ -25,21 +25,37 @@ This file is a part of Mona.
 #include "Mona/PoolThreads.h"
 #include "Mona/PoolBuffers.h"
 #include "Mona/Socket.h"
-#include <map>
+#include "Mona/FDTable.h"
+#include <vector>
 #include <atomic>
 
 namespace Mona {
 
-class SocketManager : private Task, private Startable, private TaskHandler, virtual Object {
+class SocketManager : virtual Object {
 	friend class Socket;
 public:
-	SocketManager(TaskHandler& handler, const PoolBuffers& poolBuffers, PoolThreads& poolThreads, UInt32 bufferSize = 0, const std::string& name = "SocketManager");
-	SocketManager(const PoolBuffers& poolBuffers, PoolThreads& poolThreads, UInt32 bufferSize = 0, const std::string& name = "SocketManager");
+	// reactors==0 means one reactor by processor
+	SocketManager(TaskHandler& handler, const PoolBuffers& poolBuffers, PoolThreads& poolThreads, UInt32 bufferSize = 0, const std::string& name = "SocketManager", UInt16 reactors = 1);
+	SocketManager(const PoolBuffers& poolBuffers, PoolThreads& poolThreads, UInt32 bufferSize = 0, const std::string& name = "SocketManager", UInt16 reactors = 1);
 	virtual ~SocketManager() { stop(); }
 
 	bool					start(Exception& ex);
 	void					stop();
 
+	bool					running() const { return _running; }
+	const std::string&		name() const { return _name; }
+	UInt16					reactors() const { return (UInt16)_reactors.size(); }
+
+	// Opt-in edge-triggered polling (Linux), to call before start. Sockets which read until EAGAIN (TCP clients and UDP sockets)
+	// need no more epoll_ctl to rearm reading, and TCP clients are registered one time for reading and writing.
+	// Returns false if unsupported
+	bool					setEdgeTriggered(bool enable);
+	bool					edgeTriggered() const { return _edgeTriggered; }
+
+	// statistics of dispatching, events/wakeUps gives the number of socket events by wakeup
+	UInt64					wakeUps() const;
+	UInt64					events() const;
+
 	PoolThreads&			poolThreads;
 	const PoolBuffers&		poolBuffers;
 	const UInt32			bufferSize;
@@ -52,44 +68,104 @@ private:
 		virtual void	onReadable(Exception& ex) {}
 		virtual void	onError(const std::string& error) {}
 	};
-	
-	// add a socket with a valid file descriptor to manage it
-	bool add(Exception& ex,Socket& socket) const;
 
-	// remove a socket with a valid file descriptor to unmanage it
-	void remove(Socket& socket) const;
+	class Reactor;
 
-	bool startWrite(Exception& ex, Socket& socket) const;
-	bool stopWrite(Exception& ex, Socket& socket) const;
+	// A read/error event of one socket
+	struct SocketEvent {
+		SocketEvent(std::unique_ptr<Socket>* ppSocket, NET_SOCKET sockfd, UInt32 event, int error) : ppSocket(ppSocket), sockfd(sockfd), event(event), error(error) {}
+		std::unique_ptr<Socket>*	ppSocket;
+		NET_SOCKET					sockfd;
+		UInt32						event;
+		int							error;
+	};
 
-	void					requestHandle();
-	void					clear();
-	void					run(Exception& ex);
-	void					handle(Exception& ex);
+	// All the events of one reactor wakeup, given in one time to the handler thread.
+	// Holders of removed sockets are deleted with the batch, so after the handling of their last events
+	class SocketEvents : public Task, virtual Object {
+	public:
+		SocketEvents(Reactor& reactor);
+		virtual ~SocketEvents();
+
+		std::vector<SocketEvent>				events;
+		std::vector<std::unique_ptr<Socket>*>	releasings;
 
-	bool								_selfHandler;
-	Exception							_ex;
+		void handle(Exception& ex);
+	private:
+		Reactor&					_reactor;
+	};
 
-	mutable std::atomic<int>			_counter;
-	mutable Event						_eventInit;
-	mutable std::mutex					_mutex;
+	// One event loop (epoll on linux, message window on windows) running in its own thread,
+	// a socket stays on the same reactor all its life.
+	// Without external handler, events are handled directly in the reactor thread,
+	// otherwise they are posted to the handler and the reactor thread never waits it,
+	// except for the sockets which read in reactor (Socket::readsInReactor) handled directly too under the reactor lock
+	// (their removal, and so their deletion, waits the end of the reading). So the reading of these sockets scales with the reactors,
+	// whereas the others (TCP sessions) are read by the handler thread
+	class Reactor : private Task, private Startable, private TaskHandler, virtual Object {
+		friend class SocketManager;
+	public:
+		Reactor(SocketManager& manager, UInt16 index, const std::string& name);
+		Reactor(SocketManager& manager, TaskHandler& handler, UInt16 index, const std::string& name);
+		virtual ~Reactor() { stop(); }
 
-    mutable std::map<NET_SOCKET, std::unique_ptr<Socket>*>		_sockets;
+		bool					start(Exception& ex);
+		void					stop();
 
-    FakeSocket							_fakeSocket;
-    Exception							_exSkip;
+		const UInt16			index;
+	private:
+		void					requestHandle();
+		void					run(Exception& ex);
+		void					handle(Exception& ex);
+
+		void					dispatch(std::unique_ptr<Socket>* ppSocket, NET_SOCKET sockfd, UInt32 event, int error = 0);
+		void					release(std::unique_ptr<Socket>* ppSocket);
+		// post the events of this wakeup to the handler
+		void					flush(UInt32 count);
+		void					process(const SocketEvent& event);
+
+		SocketManager&						_manager;
+		TaskHandler&						_handler;
+		bool								_selfHandler;
+		mutable std::mutex					_mutex;
+		Exception							_ex;
+
+		mutable std::atomic<int>			_counter;
+		mutable Event						_eventInit;
+
+		std::shared_ptr<SocketEvents>		_pEvents;
+		std::atomic<UInt64>					_wakeUps;
+		std::atomic<UInt64>					_events;
+
+		FakeSocket							_fakeSocket;
+		Exception							_exSkip;
 #if defined(_WIN32)
-    HWND								_eventSystem;
+		HWND								_eventSystem;
 #else
-	int									_eventSystem;
+		int									_eventSystem;
 #endif
-	int									_eventFD; // used just in linux case
+		int									_eventFD; // used just in linux case
+	};
 	
-	UInt32								_currentEvent;
-	int									_currentError;
+	// add a socket with a valid file descriptor to manage it
+	bool add(Exception& ex,Socket& socket) const;
+
+	// remove a socket with a valid file descriptor to unmanage it
+	void remove(Socket& socket) const;
+
+	bool startWrite(Exception& ex, Socket& socket) const { return update(ex, socket, true); }
+	bool stopWrite(Exception& ex, Socket& socket) const { return update(ex, socket, false); }
+	// set the events to poll, with a posting handler read events are disarmed while the socket has a read pending
+	bool update(Exception& ex, Socket& socket, bool writing) const;
+
+	void					clear();
+
+	std::string								_name;
+	volatile bool							_running;
+	bool									_edgeTriggered;
+	std::vector<std::unique_ptr<Reactor>>	_reactors;
 
-	std::unique_ptr<Socket>*			_ppSocket;
-    NET_SOCKET							_sockfd;
+	mutable FDTable<std::unique_ptr<Socket>>	_sockets;
 };
 
 
@@ -24,6 +24,7 @@ This file is a part of Mona.
 #include "Mona/PoolThread.h"
 #include "Mona/SocketAddress.h"
 #include "Mona/Expirable.h"
+#include "Mona/PoolBuffer.h"
 #include <memory>
 
 
@@ -39,19 +40,28 @@ public:
 
 	virtual const UInt8*	data() { return _data; }
 	virtual UInt32			size() { return _size; }
+	// bytes which remain to send
+	virtual UInt32			pending() { return available() ? (size() - _position) : 0; }
+	// destination of a datagram, NULL for a connected socket
+	virtual const SocketAddress* destination() { return NULL; }
 
 protected:
 	SocketSender(const char* name);
 	SocketSender(const char* name,const UInt8* data, UInt32 size);
-	virtual ~SocketSender();
+	// takes the ownership of the buffer, data are never copied
+	SocketSender(const char* name,PoolBuffer& pBuffer);
+	virtual ~SocketSender() {}
 
 
 	// if return true and ex==true it will display a warning, otherwise return false == failed
 	bool							run(Exception& ex);
 
+	// send data, returns false if it remains data to send
+	virtual bool					flush(Exception& ex,Socket& socket);
+
 private:
-	// send data
-	bool							flush(Exception& ex,Socket& socket);
+	// copy data given on construction to be able to send them later
+	void							retain(const PoolBuffers& poolBuffers);
 
 
 	//// TO OVERLOAD ////////
@@ -64,7 +74,8 @@ private:
 	UInt32						_position;
 	UInt8*						_data;
 	UInt32						_size;
-	bool						_memcopied;
+	std::unique_ptr<PoolBuffer>	_ppBuffer; // owned data
+	UInt32						_queued; // bytes counted in the queue of the socket
 };
 
 
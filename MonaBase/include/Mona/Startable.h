@@ -22,6 +22,7 @@ This file is a part of Mona.
 #include "Mona/Exceptions.h"
 #include "Mona/Event.h"
 #include <thread>
+#include <functional>
 
 
 namespace Mona {
@@ -54,6 +55,12 @@ public:
 	bool				running() const { return !_stop; }
 	const std::string&	name() const { return _name; }
 
+	// function called by each Startable thread which ends, to release what a module keeps for this thread (a cache...),
+	// returns its id to remove it
+	static UInt32		AddThreadEnd(const std::function<void()>& function);
+	// waits the end of the calls in progress
+	static void			RemoveThreadEnd(UInt32 id);
+
 protected:
 	Startable(const std::string& name);
 	virtual ~Startable();
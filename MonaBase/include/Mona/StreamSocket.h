@@ -35,7 +35,9 @@ public:
 	void shutdown(Exception& ex, ShutdownType type = BOTH) { return Socket::shutdown(ex, type); }
 
 	int receiveBytes(Exception& ex, void* buffer, int length, int flags = 0) { return Socket::receiveBytes(ex, buffer, length, flags); }
+	int receive(Exception& ex, Buffer& buffer, UInt32 offset) { return Socket::receive(ex, buffer, offset); }
 	int sendBytes(Exception& ex, const void* buffer, int length, int flags = 0) { return Socket::sendBytes(ex, buffer, length, flags); }
+	int sendBytes(Exception& ex, const Part* parts, UInt32 count, int flags = 0) { return Socket::sendBytes(ex, parts, count, flags); }
 
 };
 
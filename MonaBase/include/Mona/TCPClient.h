@@ -36,6 +36,8 @@ public:
 	bool					connect(Exception& ex, const SocketAddress& address);
 	bool					connected() { return _connected; }
 	bool					send(Exception& ex, const UInt8* data, UInt32 size);
+	// sends the buffer without copying it, takes its ownership
+	bool					send(Exception& ex, PoolBuffer& pBuffer);
 
 	template<typename SenderType>
 	bool send(Exception& ex,const std::shared_ptr<SenderType>& pSender) {
@@ -63,6 +65,7 @@ private:
 
 
 	void					onReadable(Exception& ex);
+	bool					drains() const { return true; }
 	
 	int						sendIntern(const UInt8* data,UInt32 size);
 
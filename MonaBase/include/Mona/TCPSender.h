@@ -29,10 +29,12 @@ class TCPSender : public SocketSender, virtual Object {
 public:
 	TCPSender(const char* name) : SocketSender(name) {}
 	TCPSender(const char* name,const UInt8* data, UInt32 size) : SocketSender(name,data, size) {}
+	TCPSender(const char* name,PoolBuffer& pBuffer) : SocketSender(name,pBuffer) {}
 
 
 private:
-	UInt32	send(Exception& ex, Socket& socket, const UInt8* data, UInt32 size) { return ((StreamSocket&)socket).sendBytes(ex,data, (int)size); }
+	// never blocks, what can't be sent is queued until the socket is writable
+	UInt32	send(Exception& ex, Socket& socket, const UInt8* data, UInt32 size) { return ((StreamSocket&)socket).sendBytes(ex,data, (int)size, NET_MSG_DONTWAIT); }
 };
 
 
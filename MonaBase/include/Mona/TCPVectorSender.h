@@ -0,0 +1,71 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include "Mona/TCPSender.h"
+#include <vector>
+
+namespace Mona {
+
+/// TCPSender which can insert between the bytes of its data() references on external buffers (payloads),
+/// all is sent in one gather call (writev/WSASend) without copying the payloads behind their headers.
+/// A partial sending is resumed in the middle of the part where it has stopped
+class TCPVectorSender : public TCPSender, virtual Object {
+	friend class Socket;
+public:
+	bool	available() { return _parts.empty() ? SocketSender::available() : (_part < _parts.size() || (data() && _cut < size())); }
+	UInt32	pending();
+
+	// inserts after the bytes written until now in data() a reference on size bytes of data, pOwner keeps them alive until sent
+	template<typename OwnerType>
+	void	reference(const std::shared_ptr<OwnerType>& pOwner, const UInt8* data, UInt32 size) {
+		if (size == 0)
+			return;
+		cut();
+		_parts.emplace_back(data, 0, size);
+		_owners.emplace_back(pOwner);
+	}
+
+protected:
+	TCPVectorSender(const char* name) : TCPSender(name), _part(0), _offset(0), _cut(0) {}
+
+	bool	flush(Exception& ex, Socket& socket);
+
+private:
+	// add in parts the bytes written in data() since the last cut
+	void	cut();
+
+	struct Part {
+		Part(const UInt8* data, UInt32 offset, UInt32 size) : data(data), offset(offset), size(size) {}
+		const UInt8*	data; // NULL for a part of data()
+		UInt32			offset;
+		UInt32			size;
+	};
+
+	std::vector<Part>					_parts;
+	std::vector<std::shared_ptr<void>>	_owners;
+	UInt32								_part; // part to send
+	UInt32								_offset; // bytes already sent of this part
+	UInt32								_cut; // bytes of data() already in parts
+};
+
+
+} // namespace Mona
@@ -21,6 +21,7 @@ This file is a part of Mona.
 
 #include "Mona/Mona.h"
 #include "Mona/Exceptions.h"
+#include <memory>
 
 namespace Mona {
 
@@ -32,6 +33,8 @@ public:
 	virtual void	handle(Exception& ex)=0;
 protected:
 	void waitHandle();
+	// asynchronous version of waitHandle, pThis must be a shared pointer on this task
+	void postHandle(const std::shared_ptr<Task>& pThis);
 private:
 	TaskHandler&	_handler;
 };
@@ -22,17 +22,24 @@ This file is a part of Mona.
 #include "Mona/Mona.h"
 #include "Mona/Task.h"
 #include "Mona/Event.h"
+#include "Mona/MPSCQueue.h"
 #include <mutex>
+#include <memory>
 
 
 namespace Mona {
 
 class TaskHandler : virtual Object {
 public:
-	TaskHandler() : _pTask(NULL), _stop(true) {}
+	TaskHandler() : _pTask(NULL), _stop(true), _signaled(false), _dropped(0) {}
 	virtual ~TaskHandler() {stop(); }
 
+	// blocks the caller thread until the task is handled
 	void waitHandle(Task& task);
+	// queues the task without waiting, the handler thread will handle it with the other queued tasks
+	void postHandle(const std::shared_ptr<Task>& pTask);
+	// tasks posted since the handler has been stopped, never handled
+	UInt32 dropped() const { return _dropped; }
 
 protected:
 	void start();
@@ -47,6 +54,10 @@ private:
 	Task*					_pTask;
 	Event					_event;
 	volatile bool			_stop;
+
+	MPSCQueue<std::shared_ptr<Task>>	_tasks;
+	std::atomic<bool>					_signaled;
+	std::atomic<UInt32>					_dropped;
 };
 
 
@@ -0,0 +1,86 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+
+#pragma once
+
+#include "Mona/Mona.h"
+
+namespace Mona {
+
+/// Hierarchical timer wheel with a millisecond resolution, 4 levels of 256 slots (256ms, 65s, 4.6h and 49 days).
+/// Timers are intrusive, set and cancel are in O(1), and raise visits only the timers due
+/// (plus the cascade of an upper level slot every 256ms). Not thread-safe, to use by one thread
+class Timers : virtual Object {
+public:
+	class Timer : virtual Object {
+		friend class Timers;
+	public:
+		Timer() : _pTimers(NULL), _pPrev(NULL), _pNext(NULL), _expiration(0) {}
+		virtual ~Timer() { cancel(); }
+
+		bool		active() const { return _pTimers != NULL; }
+		// time of the next raise, in ms (see Timers::Now)
+		Int64		expiration() const { return _expiration; }
+		void		cancel();
+
+	private:
+		// returns the delay in ms before the next raise, or 0 to stop the timer (which can also be set again during the call)
+		virtual UInt32	onTimer(Int64 now) = 0;
+
+		Timers*		_pTimers;
+		Timer*		_pPrev;
+		Timer*		_pNext;
+		Int64		_expiration;
+	};
+
+	Timers();
+	virtual ~Timers();
+
+	// monotonic time in ms
+	static Int64	Now();
+
+	// (re)arm timer to raise in delay ms
+	void			set(Timer& timer, UInt32 delay) { set(timer, Now(), delay); }
+	void			set(Timer& timer, Int64 now, UInt32 delay);
+
+	// raise the timers due, returns the delay in ms before the next timer due or 0 if there is no more timer
+	UInt32			raise() { return raise(Now()); }
+	UInt32			raise(Int64 now);
+
+	UInt32			count() const { return _count; }
+
+private:
+	enum {
+		LEVELS = 4,
+		BITS = 8,
+		SLOTS = 1 << BITS
+	};
+
+	void			insert(Timer& timer);
+	void			remove(Timer& timer);
+	UInt32			next() const;
+
+	Timer*			_slots[LEVELS][SLOTS];
+	Int64			_current; // next ms to raise
+	UInt32			_count;
+};
+
+
+} // namespace Mona
@@ -32,6 +32,8 @@ public:
 	UDPSender(const char* name,const UInt8* data, UInt32 size) : SocketSender(name,data, size) {}
 
 	SocketAddress			address;
+
+	const SocketAddress*	destination() { return address ? &address : NULL; }
 private:
 	UInt32					send(Exception& ex, Socket& socket, const UInt8* data, UInt32 size) {
 		return address ? ((DatagramSocket&)socket).sendTo(ex, data, size, address) : ((DatagramSocket&)socket).sendBytes(ex, data, size);
@@ -23,6 +23,8 @@ This file is a part of Mona.
 #include "Mona/Mona.h"
 #include "Mona/DatagramSocket.h"
 #include "Mona/PoolBuffer.h"
+#include <deque>
+#include <vector>
 
 namespace Mona {
 
@@ -34,6 +36,18 @@ public:
 	bool					connect(Exception& ex, const SocketAddress& address);
 	void					close();
 
+	// Opt-in batch mode (Linux), reception reads until count datagrams of maximum datagramSize bytes by recvmmsg,
+	// and sending queues datagrams to flush them by sendmmsg. Returns false if unsupported (count<2 disables it)
+	bool					setBatch(UInt16 count, UInt32 datagramSize = 2048);
+	UInt16					batch() const { return DatagramSocket::batch(); }
+	// Opt-in UDP offloads of the batch mode (Linux), to call once bound. GSO gives to the kernel in one message
+	// the consecutive datagrams of a same size to a same destination, GRO receives datagrams coalesced by the kernel
+	// (in buffers of 64KB) and splits them before onReception. Return false if unsupported
+	bool					setGSO(bool enable) { return DatagramSocket::setGSO(enable); }
+	bool					gso() const { return DatagramSocket::gso(); }
+	bool					setGRO(bool enable);
+	bool					gro() const { return DatagramSocket::gro(); }
+
 	bool					send(Exception& ex, const UInt8* data, UInt32 size);
 	bool					send(Exception& ex, const UInt8* data, UInt32 size, const SocketAddress& address);
 
@@ -57,6 +71,9 @@ protected:
 private:
 	virtual void			onReception(const UInt8* data, UInt32 size, const SocketAddress& address) = 0;
 	void					onReadable(Exception& ex);
+	bool					drains() const { return true; }
+	// returns true if all the buffers have been filled (maybe more to read)
+	bool					receiveBatch(Exception& ex);
 
 	bool					_allowBroadcast;
 	bool					_broadcasting;
@@ -65,6 +82,12 @@ private:
 	SocketAddress			_address;
 	SocketAddress			_peerAddress;
 	PoolBuffer				_pBuffer;
+
+	UInt32					_datagramSize;
+	std::deque<PoolBuffer>	_buffers; // batch mode
+	std::vector<Buffer*>	_pBuffers;
+	std::vector<SocketAddress> _addresses;
+	std::vector<UInt16>		_segments;
 };
 
 
@@ -0,0 +1,94 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include <atomic>
+
+namespace Mona {
+
+/// Bounded Chase-Lev deque: the owner thread pushes and pops at the bottom (LIFO),
+/// the other threads steal at the top (FIFO). Type must be a trivial type (a pointer typically)
+template<typename Type>
+class WorkStealingDeque : virtual Object {
+public:
+	// capacity is rounded up to a power of 2
+	WorkStealingDeque(UInt32 capacity=1024) : _top(0), _bottom(0) {
+		UInt32 size(2);
+		while (size < capacity)
+			size <<= 1;
+		_mask = size - 1;
+		_items = new std::atomic<Type>[size];
+	}
+	virtual ~WorkStealingDeque() { delete [] _items; }
+
+	// Owner thread, returns false if full
+	bool push(Type value) {
+		Int64 bottom = _bottom.load(std::memory_order_relaxed);
+		Int64 top = _top.load(std::memory_order_acquire);
+		if (bottom - top > (Int64)_mask)
+			return false;
+		_items[bottom & _mask].store(value, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	// Owner thread
+	bool pop(Type& value) {
+		Int64 bottom = _bottom.load(std::memory_order_relaxed) - 1;
+		_bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		Int64 top = _top.load(std::memory_order_relaxed);
+		if (top > bottom) {
+			// empty
+			_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return false;
+		}
+		value = _items[bottom & _mask].load(std::memory_order_relaxed);
+		if (top == bottom) {
+			// last item, race with thieves
+			bool won = _top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+			_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return won;
+		}
+		return true;
+	}
+
+	// Any thread, can fail if an other thread takes the item at the same time
+	bool steal(Type& value) {
+		Int64 top = _top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		Int64 bottom = _bottom.load(std::memory_order_acquire);
+		if (top >= bottom)
+			return false;
+		value = _items[top & _mask].load(std::memory_order_relaxed);
+		return _top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+	}
+
+private:
+	std::atomic<Type>*		_items;
+	UInt32					_mask;
+	std::atomic<Int64>		_top;
+	std::atomic<Int64>		_bottom;
+};
+
+
+} // namespace Mona
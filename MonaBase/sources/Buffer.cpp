@@ -18,6 +18,7 @@ This file is a part of Mona.
 */
 
 #include "Mona/Buffer.h"
+#include "Mona/Memory.h"
 
 
 
@@ -25,6 +26,32 @@ namespace Mona {
 
 Buffer	Buffer::Null(true,true,true);
 
+// heap memory of the buffers (pooled or not), the memory given by a subclass is counted by this one
+static Memory::Counter Buffers("buffers");
+
+Buffer::Buffer(UInt32 size) : _offset(0),_external(false),_capacity(size==0 ? 64 : size), _size(size) {
+	_data = _buffer = new UInt8[_capacity]; // not zeroed
+	Buffers.add(_capacity, 1);
+}
+
+Buffer::Buffer(UInt8* buffer,UInt32 capacity,bool) : _offset(0),_data(buffer),_buffer(buffer),_external(true),_capacity(capacity), _size(0) {
+}
+
+Buffer::~Buffer() {
+	release();
+}
+
+void Buffer::release() {
+	if (!_buffer)
+		return;
+	free(_buffer);
+	if (!_external)
+		Buffers.add(-(Int64)(_capacity + _offset), -1);
+	_external = false;
+	_data = _buffer = NULL;
+	_capacity = _size = _offset = 0;
+}
+
 void Buffer::clip(UInt32 offset) {
 	if (offset > _size)
 		offset = _size;
@@ -57,21 +84,40 @@ bool Buffer::resize(UInt32 size,bool preserveData) {
 		return false;
 	}
 	
+	// geometric growth on the whole allocation (a clip can have reduced _capacity until 0)
+	UInt32 capacity(_capacity+_offset);
 	do {
-		_capacity *= 2;
-	} while (size > _capacity);
-
-	UInt8* oldData = _data;
-	_data = new UInt8[_capacity]();
-	if (preserveData && _size>0)
-		memcpy(_data, oldData, _size);
-	delete [] _buffer;
-	_offset = 0;
-	_buffer=_data;
+		capacity *= 2;
+	} while (size > capacity);
+
+	reallocate(capacity, preserveData ? _size : 0);
 	_size = size;
 	return true;
 }
 
+bool Buffer::reserve(UInt32 capacity) {
+	if (capacity <= _capacity)
+		return true;
+	if (!_buffer)
+		return false;
+	reallocate(capacity, _size);
+	return true;
+}
+
+void Buffer::reallocate(UInt32 capacity, UInt32 preserved) {
+	UInt8* data = new UInt8[capacity]; // not zeroed
+	if (preserved>0)
+		memcpy(data, _data, preserved);
+	free(_buffer);
+	if (!_external)
+		Buffers.add(-(Int64)(_capacity+_offset), -1);
+	Buffers.add(capacity, 1);
+	_external = false;
+	_data = _buffer = data;
+	_offset = 0;
+	_capacity = capacity;
+}
+
 
 
 } // namespace Mona
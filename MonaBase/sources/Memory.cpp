@@ -0,0 +1,72 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+#include "Mona/Memory.h"
+#include "Mona/Logs.h"
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+
+namespace Mona {
+
+// function statics, counters are static objects of other translation units
+static mutex& Mutex() {
+	static mutex Mutex;
+	return Mutex;
+}
+static vector<Memory::Counter*>& Counters() {
+	static vector<Memory::Counter*> Counters;
+	return Counters;
+}
+
+Memory::Counter::Counter(const char* name) : name(name), _bytes(0), _objects(0) {
+	lock_guard<mutex> lock(Mutex());
+	Counters().emplace_back(this);
+}
+
+Memory::Counter::~Counter() {
+	lock_guard<mutex> lock(Mutex());
+	vector<Counter*>& counters(Counters());
+	for (auto it = counters.begin(); it != counters.end(); ++it) {
+		if (*it != this)
+			continue;
+		counters.erase(it);
+		break;
+	}
+}
+
+void Memory::ForEach(const function<void(const Counter&)>& function) {
+	lock_guard<mutex> lock(Mutex());
+	for (Counter* pCounter : Counters())
+		function(*pCounter);
+}
+
+void Memory::Dump() {
+	UInt64 total(0);
+	ForEach([&total](const Counter& counter) {
+		NOTE("Memory of ", counter.name, ", ", counter.bytes(), " bytes (", counter.objects(), " objects)");
+		total += counter.bytes();
+	});
+	NOTE("Memory accounted, ", total, " bytes");
+}
+
+
+} // namespace Mona
@@ -19,52 +19,422 @@ This file is a part of Mona.
 
 #include "Mona/PoolBuffers.h"
 #include "Mona/PoolBuffer.h"
-//#include <atomic>
+#include "Mona/Memory.h"
+#include "Mona/Startable.h"
+#if _OS == _OS_LINUX
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 
 using namespace std;
 
+// size of a huge page on x86-64, buffers are carved from chunks of this size
+#define CHUNK_SIZE	0x200000
+
 
 namespace Mona {
 
+static const UInt32 Capacities[PoolBuffers::CLASSES] = { 256, 2048, 16384, 65536 };
+static const UInt32 CacheMaximums[PoolBuffers::CLASSES] = { 64, 32, 8, 4 };
+
+// buffers waiting in the pools (caches included), a part of the "buffers" memory or of the chunks
+static Memory::Counter Pooled("pooledBuffers");
+// chunks reserved for the buffers (huge pages), their buffers are not counted again in "buffers"
+static Memory::Counter Chunked("poolChunks");
+
+static void Delete(Buffer* pBuffer) {
+	Pooled.add(-(Int64)pBuffer->capacity(), -1);
+	delete pBuffer;
+}
+
+// counters of a cache are written under its lock, no need of an atomic increment
+static void Increment(atomic<UInt64>& counter) {
+	counter.store(counter.load(memory_order_relaxed) + 1, memory_order_relaxed);
+}
+
+static void* AllocateChunk() {
+#if _OS == _OS_LINUX
+	// explicit huge pages first (requires vm.nr_hugepages)
+	void* chunk = mmap(NULL, CHUNK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (chunk != MAP_FAILED)
+		return chunk;
+	// else transparent huge pages, the chunk has to be aligned on a huge page
+	UInt8* area = (UInt8*)mmap(NULL, 2 * CHUNK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (area == MAP_FAILED)
+		return NULL;
+	UInt8* aligned = (UInt8*)(((uintptr_t)area + CHUNK_SIZE - 1) & ~(uintptr_t)(CHUNK_SIZE - 1));
+	if (aligned > area)
+		munmap(area, aligned - area);
+	munmap(aligned + CHUNK_SIZE, area + CHUNK_SIZE - aligned);
+	madvise(aligned, CHUNK_SIZE, MADV_HUGEPAGE);
+	return aligned;
+#else
+	return NULL;
+#endif
+}
+
+static void FreeChunk(void* chunk) {
+#if _OS == _OS_LINUX
+	munmap(chunk, CHUNK_SIZE);
+#endif
+}
+
+// buffer on a block of chunk, the block returns to its chunks when the buffer is deleted or grows
+class PoolBuffers::ChunkBuffer : public Buffer {
+public:
+	ChunkBuffer(const shared_ptr<Chunks>& pChunks, UInt8* block, UInt32 capacity) : Buffer(block, capacity, true), _pChunks(pChunks), _block(block) {}
+	virtual ~ChunkBuffer() { release(); }
+
+private:
+	void free(UInt8* buffer) {
+		if (buffer != _block) {
+			delete [] buffer; // heap memory of a resize
+			return;
+		}
+		lock_guard<mutex> lock(_pChunks->mutex);
+		_pChunks->blocks.emplace_back(_block);
+		_block = NULL;
+	}
+
+	shared_ptr<Chunks>	_pChunks;
+	UInt8*				_block;
+};
+
+PoolBuffers::Chunks::~Chunks() {
+	for (void* chunk : chunks)
+		FreeChunk(chunk);
+	Chunked.add(-(Int64)(chunks.size() * CHUNK_SIZE), -(Int64)chunks.size());
+}
+
+PoolBuffers::Class::Class() : capacity(0), cacheMaximum(0), hits(0), misses(0) {
+	for (UInt8 node = 0; node < NODES; ++node) {
+		lowWater[node] = 0;
+		chunks[node].reset(new Chunks());
+	}
+}
+
+atomic<UInt32>							PoolBuffers::_Ids(0);
+THREAD_LOCAL PoolBuffers::CacheSlot	PoolBuffers::_CacheSlots[CACHE_SLOTS];
+THREAD_LOCAL UInt8						PoolBuffers::_NextSlot(0);
+
+PoolBuffers::Cache::Cache(UInt32 generation) : node(CurrentNode()), generation(generation) {
+	_locked.clear();
+	for (UInt8 i = 0; i < CLASSES; ++i) {
+		hits[i] = 0;
+		misses[i] = 0;
+		available[i] = 0;
+		lowWater[i] = 0;
+	}
+}
+
+PoolBuffers::Cache::~Cache() {
+	clear();
+}
+
+void PoolBuffers::Cache::clear() {
+	for (UInt8 i = 0; i < CLASSES; ++i) {
+		for (Buffer* pBuffer : buffers[i])
+			Delete(pBuffer);
+		buffers[i].clear();
+		hits[i] = 0;
+		misses[i] = 0;
+		available[i] = 0;
+		lowWater[i] = 0;
+	}
+}
+
+PoolBuffers::PoolBuffers(UInt32 maximumCapacity) : _id(++_Ids), _generation(0), _count(0), _maximumCapacity(maximumCapacity), _unpooled(0), _hugePages(false) {
+	while (_count < CLASSES && Capacities[_count] <= maximumCapacity) {
+		_classes[_count].capacity = Capacities[_count];
+		_classes[_count].cacheMaximum = CacheMaximums[_count];
+		++_count;
+	}
+	// the cache of a thread which ends goes to the other threads
+	_threadEnd = Startable::AddThreadEnd([this]() { releaseCache(); });
+}
+
+PoolBuffers::~PoolBuffers() {
+	Startable::RemoveThreadEnd(_threadEnd);
+	clear();
+	// caches of the threads not ended (or not Startable), their slots will never match again the id of this pool
+	for (auto& it : _caches)
+		delete it.second;
+	// the chunks are freed with the classes, or later with the last of their buffers still used
+}
+
+bool PoolBuffers::setHugePages(bool enable) {
+#if _OS == _OS_LINUX
+	_hugePages = enable;
+	return true;
+#else
+	return !enable;
+#endif
+}
+
+UInt64 PoolBuffers::chunksSize() const {
+	UInt64 size(0);
+	for (UInt8 i = 0; i < _count; ++i) {
+		for (const shared_ptr<Chunks>& pChunks : _classes[i].chunks) {
+			lock_guard<mutex> lock(pChunks->mutex);
+			size += pChunks->chunks.size() * CHUNK_SIZE;
+		}
+	}
+	return size;
+}
+
+UInt8 PoolBuffers::CurrentNode() {
+#if _OS == _OS_LINUX
+	unsigned cpu, node;
+	if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0)
+		return node % NODES;
+#endif
+	return 0;
+}
+
 void PoolBuffers::clear() {
 	lock_guard<mutex> lock(_mutex);
-	for (Buffer* pBuffer : _buffers)
-		delete pBuffer;
-	_buffers.clear();
+	// the caches stay to their threads which can be running, emptied under their lock
+	for (auto& it : _caches) {
+		lock_guard<Cache> lockCache(*it.second);
+		it.second->clear();
+	}
+	for (UInt8 i = 0; i < _count; ++i) {
+		Class& sizeClass(_classes[i]);
+		sizeClass.hits = sizeClass.misses = 0;
+		lock_guard<mutex> lockClass(sizeClass.mutex);
+		for (UInt8 node = 0; node < NODES; ++node) {
+			for (Buffer* pBuffer : sizeClass.buffers[node])
+				Delete(pBuffer);
+			sizeClass.buffers[node].clear();
+			sizeClass.lowWater[node] = 0;
+		}
+	}
 }
 
-// static atomic_int n;
+void PoolBuffers::manage() {
+	// thread caches are lock-free, each thread trims its cache on its next request
+	++_generation;
+	for (UInt8 i = 0; i < _count; ++i) {
+		Class& sizeClass(_classes[i]);
+		lock_guard<mutex> lock(sizeClass.mutex);
+		for (UInt8 node = 0; node < NODES; ++node) {
+			vector<Buffer*>& buffers(sizeClass.buffers[node]);
+			UInt32& lowWater(sizeClass.lowWater[node]);
+			// the lowWater oldest buffers have not been required since the last call
+			if (lowWater > buffers.size())
+				lowWater = buffers.size();
+			for (UInt32 j = 0; j < lowWater; ++j)
+				Delete(buffers[j]);
+			buffers.erase(buffers.begin(), buffers.begin() + lowWater);
+			lowWater = buffers.size();
+		}
+	}
+}
 
-Buffer* PoolBuffers::beginBuffer(UInt32 size) const {
-	Buffer* pBuffer(NULL);
+PoolBuffers::Counters PoolBuffers::counters(UInt8 index) const {
+	Counters counters;
+	if (index >= _count)
+		return counters;
+	Class& sizeClass(_classes[index]);
+	counters.capacity = sizeClass.capacity;
+	lock_guard<mutex> lock(_mutex);
+	counters.hits = sizeClass.hits;
+	counters.misses = sizeClass.misses;
+	for (auto& it : _caches) {
+		counters.hits += it.second->hits[index];
+		counters.misses += it.second->misses[index];
+		counters.available += it.second->available[index];
+	}
+	lock_guard<mutex> lockClass(sizeClass.mutex);
+	for (vector<Buffer*>& buffers : sizeClass.buffers)
+		counters.available += buffers.size();
+	return counters;
+}
+
+UInt64 PoolBuffers::hits() const {
+	UInt64 result(0);
+	for (UInt8 i = 0; i < _count; ++i)
+		result += counters(i).hits;
+	return result;
+}
+
+UInt64 PoolBuffers::misses() const {
+	UInt64 result(0);
+	for (UInt8 i = 0; i < _count; ++i)
+		result += counters(i).misses;
+	return result;
+}
+
+PoolBuffers::Cache& PoolBuffers::cache() const {
+	CacheSlot* pFree(NULL);
+	for (CacheSlot& slot : _CacheSlots) {
+		if (slot.pool == _id)
+			return *slot.pCache;
+		if (!slot.pool && !pFree)
+			pFree = &slot;
+	}
+	// first call of this thread (or its slot has been taken by an other pool since)
+	lock_guard<mutex> lock(_mutex);
+	Cache*& pCache(_caches[this_thread::get_id()]);
+	if (!pCache)
+		pCache = new Cache(_generation);
+	if (!pFree)
+		pFree = &_CacheSlots[_NextSlot++ % CACHE_SLOTS];
+	pFree->pool = _id;
+	pFree->pCache = pCache;
+	return *pCache;
+}
+
+void PoolBuffers::trim(Cache& cache) const {
+	cache.generation = _generation;
+	for (UInt8 i = 0; i < _count; ++i) {
+		vector<Buffer*>& buffers(cache.buffers[i]);
+		UInt32& lowWater(cache.lowWater[i]);
+		// the lowWater oldest buffers have not been required since the last trim
+		if (lowWater > buffers.size())
+			lowWater = buffers.size();
+		for (UInt32 j = 0; j < lowWater; ++j)
+			Delete(buffers[j]);
+		buffers.erase(buffers.begin(), buffers.begin() + lowWater);
+		lowWater = buffers.size();
+		cache.available[i].store(buffers.size(), memory_order_relaxed);
+	}
+}
+
+void PoolBuffers::releaseCache() const {
+	Cache* pCache;
 	{
 		lock_guard<mutex> lock(_mutex);
-		if ((size > _maximumCapacity) || _buffers.empty()) {
-			pBuffer = new Buffer(size);
-		//	printf("New %d %p\n", ++n,pBuffer);
-			return pBuffer;
+		auto it(_caches.find(this_thread::get_id()));
+		if (it == _caches.end())
+			return;
+		pCache = it->second;
+		_caches.erase(it);
+		// keep its counters
+		for (UInt8 i = 0; i < _count; ++i) {
+			_classes[i].hits += pCache->hits[i];
+			_classes[i].misses += pCache->misses[i];
 		}
-		pBuffer = _buffers.front();
-		_buffers.pop_front();
 	}
-	if (size>0)
-		pBuffer->resize(size,false);
-	// printf("get Buffer %u\n",pBuffer->capacity());
-//	printf("Get %d %p\n", ++n,pBuffer);
+	for (CacheSlot& slot : _CacheSlots) {
+		if (slot.pool == _id)
+			slot.pool = 0;
+	}
+	// its buffers go to the other threads
+	for (UInt8 i = 0; i < _count; ++i) {
+		if (!pCache->buffers[i].empty())
+			flush(_classes[i], pCache->node, pCache->buffers[i], 0);
+	}
+	delete pCache;
+}
+
+bool PoolBuffers::refill(Class& sizeClass, UInt8 node, vector<Buffer*>& buffers) const {
+	lock_guard<mutex> lock(sizeClass.mutex);
+	vector<Buffer*>& shared(sizeClass.buffers[node]);
+	if (shared.empty())
+		return false;
+	// take the half of the cache capacity in one time
+	UInt32 count(sizeClass.cacheMaximum / 2);
+	if (count == 0)
+		count = 1;
+	if (count > shared.size())
+		count = shared.size();
+	buffers.insert(buffers.end(), shared.end() - count, shared.end());
+	shared.resize(shared.size() - count);
+	if (shared.size() < sizeClass.lowWater[node])
+		sizeClass.lowWater[node] = shared.size();
+	return true;
+}
+
+void PoolBuffers::flush(Class& sizeClass, UInt8 node, vector<Buffer*>& buffers, UInt32 keep) const {
+	lock_guard<mutex> lock(sizeClass.mutex);
+	vector<Buffer*>& shared(sizeClass.buffers[node]);
+	shared.insert(shared.end(), buffers.begin() + keep, buffers.end());
+	buffers.resize(keep);
+}
+
+Buffer* PoolBuffers::newBuffer(Class& sizeClass, UInt8 node) const {
+	if (!_hugePages)
+		return new Buffer(sizeClass.capacity);
+	const shared_ptr<Chunks>& pChunks(sizeClass.chunks[node]);
+	Chunks& chunks(*pChunks);
+	UInt8* block;
+	{
+		lock_guard<mutex> lock(chunks.mutex);
+		if (chunks.blocks.empty()) {
+			UInt8* chunk = (UInt8*)AllocateChunk();
+			if (!chunk)
+				return new Buffer(sizeClass.capacity);
+			// first touch by this thread, the pages are placed on its NUMA node
+			memset(chunk, 0, CHUNK_SIZE);
+			chunks.chunks.emplace_back(chunk);
+			Chunked.add(CHUNK_SIZE, 1);
+			for (UInt32 offset = CHUNK_SIZE; offset >= sizeClass.capacity; offset -= sizeClass.capacity)
+				chunks.blocks.emplace_back(chunk + offset - sizeClass.capacity);
+		}
+		block = chunks.blocks.back();
+		chunks.blocks.pop_back();
+	}
+	return new ChunkBuffer(pChunks, block, sizeClass.capacity);
+}
+
+Buffer* PoolBuffers::beginBuffer(UInt32 size) const {
+	UInt8 index(0);
+	while (index < _count && size > _classes[index].capacity)
+		++index;
+	if (index == _count) {
+		++_unpooled;
+		return new Buffer(size);
+	}
+	Class& sizeClass(_classes[index]);
+	Cache& cache(this->cache());
+	lock_guard<Cache> lock(cache);
+	if (cache.generation != _generation)
+		trim(cache);
+	vector<Buffer*>& buffers(cache.buffers[index]);
+	Buffer* pBuffer;
+	if (buffers.empty() && !refill(sizeClass, cache.node, buffers)) {
+		Increment(cache.misses[index]);
+		pBuffer = newBuffer(sizeClass, cache.node);
+	} else {
+		Increment(cache.hits[index]);
+		pBuffer = buffers.back();
+		buffers.pop_back();
+		Pooled.add(-(Int64)pBuffer->capacity(), -1);
+		if (buffers.size() < cache.lowWater[index])
+			cache.lowWater[index] = buffers.size();
+	}
+	cache.available[index].store(buffers.size(), memory_order_relaxed);
+	pBuffer->resize(size, false);
 	return pBuffer;
 }
 
 void PoolBuffers::endBuffer(Buffer* pBuffer) const {
-	if (pBuffer->capacity() > _maximumCapacity) {
+	pBuffer->clear(); // to fix clip, and resize to 0
+	// biggest class which can be served by this buffer
+	UInt8 index(_count);
+	while (index > 0 && pBuffer->capacity() < _classes[index - 1].capacity)
+		--index;
+	if (index-- == 0 || pBuffer->capacity() > _maximumCapacity) {
 		delete pBuffer;
 		return;
 	}
-	lock_guard<mutex> lock(_mutex);
-	// printf("release Buffer %u\n",pBuffer->capacity());
-//	printf("Release %d %p\n", --n,pBuffer);
-	pBuffer->clear(); //to fix clip, and resize to 0
-	_buffers.emplace_back(pBuffer);
+	Class& sizeClass(_classes[index]);
+	Cache& cache(this->cache());
+	lock_guard<Cache> lock(cache);
+	if (cache.generation != _generation)
+		trim(cache);
+	vector<Buffer*>& buffers(cache.buffers[index]);
+	buffers.emplace_back(pBuffer);
+	Pooled.add(pBuffer->capacity(), 1);
+	if (buffers.size() > sizeClass.cacheMaximum) {
+		flush(sizeClass, cache.node, buffers, sizeClass.cacheMaximum / 2);
+		if (buffers.size() < cache.lowWater[index])
+			cache.lowWater[index] = buffers.size();
+	}
+	cache.available[index].store(buffers.size(), memory_order_relaxed);
 }
 
 
@@ -18,50 +18,83 @@ This file is a part of Mona.
 */
 
 #include "Mona/PoolThread.h"
+#include "Mona/PoolThreads.h"
 #include "Mona/Logs.h"
 
 
 using namespace std;
 
+// deferred functions are run at the latest after this number of jobs, if the queue never empties
+#define DEFERRED_JOBS	16
 
 namespace Mona {
 
-UInt32	PoolThread::_Id(0);
 
+THREAD_LOCAL PoolThread* PoolThread::_PCurrent(NULL);
 
-void PoolThread::run(Exception& exc) {
+bool PoolThread::Defer(const function<void()>& function) {
+	if (!_PCurrent)
+		return false;
+	_PCurrent->_deferred.emplace_back(function);
+	return true;
+}
 
-	for(;;) {
+void PoolThread::schedule(Exception& ex) {
+	if (_poolThreads.schedule(ex, *this))
+		return;
+	lock_guard<mutex> lock(_mutex);
+	_jobs.clear();
+	_scheduled = false;
+}
 
-		WakeUpType wakeUpType = sleep(120000); // 2 mn sec of timeout
-		
-		for (;;) {
-			WorkThread* pWork;
-			{
-				lock_guard<mutex> lock(_mutex);
-				if(_jobs.empty()) {
-					if (wakeUpType != WAKEUP) { // STOP or TIMEOUT
-						stop(); // to set running=false!
-						return;
-					}
-					break;
-				}
-				pWork = _jobs.front().get();
+void PoolThread::run() {
+	_PCurrent = this;
+	UInt32 jobs(0); // jobs run since the first deferred function
+	for (;;) {
+		shared_ptr<WorkThread> pWork;
+		{
+			lock_guard<mutex> lock(_mutex);
+			if (!_jobs.empty()) {
+				pWork = move(_jobs.front());
+				_jobs.pop_front();
+			} else if (_deferred.empty()) {
+				_scheduled = false;
+				_PCurrent = NULL;
+				return;
 			}
+		}
+		if (!pWork) {
+			// no more job, run the deferred functions (which can queue new jobs)
+			runDeferred();
+			jobs = 0;
+			continue;
+		}
 
-			try {
-				Exception ex;
-				EXCEPTION_TO_LOG(pWork->run(ex),pWork->name);
-			} catch (exception& ex) {
-				ERROR(pWork->name,", ",ex.what());
-			} catch (...) {
-				ERROR(pWork->name,", unknown error");
-			}
+		try {
+			Exception ex;
+			EXCEPTION_TO_LOG(pWork->run(ex),pWork->name);
+		} catch (exception& ex) {
+			ERROR(pWork->name,", ",ex.what());
+		} catch (...) {
+			ERROR(pWork->name,", unknown error");
+		}
+		if (!_deferred.empty() && ++jobs >= DEFERRED_JOBS) {
+			runDeferred();
+			jobs = 0;
+		}
+	}
+}
 
-			{
-				lock_guard<mutex> lock(_mutex);
-				_jobs.pop_front();
-			}
+void PoolThread::runDeferred() {
+	vector<function<void()>> deferred;
+	deferred.swap(_deferred); // a function can defer again
+	for (function<void()>& function : deferred) {
+		try {
+			function();
+		} catch (exception& ex) {
+			ERROR("PoolThread deferred function, ",ex.what());
+		} catch (...) {
+			ERROR("PoolThread deferred function, unknown error");
 		}
 	}
 }
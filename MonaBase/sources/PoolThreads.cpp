@@ -0,0 +1,145 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+#include "Mona/PoolThreads.h"
+#include "Mona/Util.h"
+
+
+using namespace std;
+
+
+namespace Mona {
+
+// more PoolThread than workers, to limit the jobs which wait behind a long job of the same PoolThread
+#define THREADS_BY_WORKER	8
+
+THREAD_LOCAL PoolThreads::Worker* PoolThreads::_PWorker(NULL);
+
+static UInt16 WorkersCount(UInt16 threadsAvailable) {
+	return threadsAvailable == 0 ? Util::ProcessorCount() : threadsAvailable;
+}
+
+PoolThreads::PoolThreads(UInt16 threadsAvailable) : _next(0), _running(false), _queue(WorkersCount(threadsAvailable)*THREADS_BY_WORKER) {
+	threadsAvailable = WorkersCount(threadsAvailable);
+	UInt32 threads(threadsAvailable*THREADS_BY_WORKER);
+	for (UInt32 i = 0; i < threads; ++i)
+		_threads.emplace_back(new PoolThread(*this));
+	for (UInt16 i = 0; i < threadsAvailable; ++i)
+		_workers.emplace_back(new Worker(*this, i));
+}
+
+PoolThreads::~PoolThreads() {
+	join();
+	for (Worker* pWorker : _workers)
+		delete pWorker;
+	for (PoolThread* pThread : _threads)
+		delete pThread;
+}
+
+void PoolThreads::join() {
+	lock_guard<mutex> lock(_mutex);
+	// not running anymore before to stop the workers, then a schedule racing with join sees it and waits the end of join to restart them
+	_running = false;
+	// each worker runs all the jobs available before to stop
+	for (Worker* pWorker : _workers)
+		pWorker->stop();
+}
+
+bool PoolThreads::start(Exception& ex) {
+	lock_guard<mutex> lock(_mutex);
+	if (_running)
+		return true;
+	for (Worker* pWorker : _workers) {
+		if (!pWorker->start(ex))
+			return false;
+	}
+	_running = true;
+	return true;
+}
+
+bool PoolThreads::schedule(Exception& ex, PoolThread& thread) {
+	if (!_running && !start(ex))
+		return false;
+
+	// a worker keeps for itself the PoolThread that it schedules, the others will steal it if they are idle
+	Worker* pWorker(_PWorker);
+	if (!pWorker || pWorker->index >= _workers.size() || _workers[pWorker->index] != pWorker) {
+		_queue.push(&thread);
+		// join can have stopped the workers after the check of _running: the last jobs run by the workers
+		// which stop miss this one, so wait the end of join and restart them
+		// (a worker caller runs itself its last jobs, and must not wait join which waits it)
+		atomic_thread_fence(memory_order_seq_cst);
+		if (!_running && !start(ex))
+			return false;
+	} else if (!pWorker->threads.push(&thread))
+		_queue.push(&thread);
+
+	// wake up one idle worker
+	atomic_thread_fence(memory_order_seq_cst);
+	for (Worker* pIdle : _workers) {
+		if (pIdle->idle.exchange(false)) {
+			pIdle->wakeUp();
+			break;
+		}
+	}
+	return true;
+}
+
+bool PoolThreads::next(Worker& worker, PoolThread*& pThread) {
+	if (worker.threads.pop(pThread) || _queue.popShared(pThread))
+		return true;
+	for (UInt32 i = 1; i < _workers.size(); ++i) {
+		if (_workers[(worker.index + i) % _workers.size()]->threads.steal(pThread))
+			return true;
+	}
+	return false;
+}
+
+
+PoolThreads::Worker::Worker(PoolThreads& poolThreads, UInt16 index) : Startable("PoolThread" + to_string(index+1)), index(index), _poolThreads(poolThreads),
+	threads(poolThreads._threads.size()), idle(false) {
+}
+
+void PoolThreads::Worker::run(Exception& ex) {
+	_PWorker = this;
+	PoolThread* pThread(NULL);
+	for (;;) {
+		while (_poolThreads.next(*this, pThread))
+			pThread->run();
+
+		// check again after being marked idle, to not miss a wake up
+		idle = true;
+		atomic_thread_fence(memory_order_seq_cst);
+		if (_poolThreads.next(*this, pThread)) {
+			idle = false;
+			pThread->run();
+			continue;
+		}
+		if (sleep() == STOP)
+			break;
+		idle = false;
+	}
+	idle = false;
+	// stop asked, finish the jobs available
+	while (_poolThreads.next(*this, pThread))
+		pThread->run();
+}
+
+
+} // namespace Mona
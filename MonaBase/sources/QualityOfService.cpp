@@ -26,7 +26,7 @@ namespace Mona {
 
 QualityOfService QualityOfService::Null;
 
-QualityOfService::QualityOfService() : lostRate(0),byteRate(0),latency(0),_num(0),_den(0),_size(0) {
+QualityOfService::QualityOfService() : lostRate(0),byteRate(0),latency(0),congestionWindow(0),pacingRate(0),_num(0),_den(0),_size(0) {
 }
 
 
@@ -64,10 +64,17 @@ void QualityOfService::add(UInt32 ping,UInt32 size,UInt32 success,UInt32 lost) {
 		(double&)lostRate = _num/(double)_den;
 }
 
+void QualityOfService::setCongestion(UInt32 window,double rate) {
+	(UInt32&)congestionWindow = window;
+	(double&)pacingRate = rate;
+}
+
 void QualityOfService::reset() {
 	(double&)lostRate = 0;
 	(double&)byteRate = 0;
 	(UInt32&)latency = 0;
+	(UInt32&)congestionWindow = 0;
+	(double&)pacingRate = 0;
 	_size=_num=_den=0;
 	_samples.clear();
 }
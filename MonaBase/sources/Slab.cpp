@@ -0,0 +1,82 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+#include "Mona/Slab.h"
+#include "Mona/Logs.h"
+
+using namespace std;
+
+// blocks are aligned on 16 bytes, enough for any object
+#define SLAB_ALIGNMENT	16
+
+
+namespace Mona {
+
+Slab::Slab(UInt32 blockSize, UInt32 blocksByChunk) : _blockSize((max<UInt32>(blockSize, sizeof(Free)) + SLAB_ALIGNMENT - 1) & ~(SLAB_ALIGNMENT - 1)), _blocksByChunk(blocksByChunk == 0 ? 1 : blocksByChunk), _pFree(NULL), _used(0) {
+}
+
+Slab::~Slab() {
+	if (_used > 0) {
+		// chunks are leaked rather than corrupting the objects still alive
+		CRITIC("Slab deleted with ", _used, " blocks still in use");
+		return;
+	}
+	for (UInt8* pChunk : _chunks)
+		delete [] pChunk;
+}
+
+UInt32 Slab::blocks() const {
+	lock_guard<mutex> lock(_mutex);
+	return _chunks.size()*_blocksByChunk;
+}
+
+UInt32 Slab::used() const {
+	lock_guard<mutex> lock(_mutex);
+	return _used;
+}
+
+void* Slab::allocate() {
+	lock_guard<mutex> lock(_mutex);
+	if (!_pFree) {
+		// new chunk, its blocks are chained on the free list
+		UInt8* pChunk = new UInt8[_blockSize*_blocksByChunk];
+		_chunks.emplace_back(pChunk);
+		for (UInt32 i = _blocksByChunk; i > 0; --i) {
+			Free* pBlock = (Free*)(pChunk + (i - 1)*_blockSize);
+			pBlock->pNext = _pFree;
+			_pFree = pBlock;
+		}
+	}
+	Free* pBlock(_pFree);
+	_pFree = pBlock->pNext;
+	++_used;
+	return pBlock;
+}
+
+void Slab::release(void* pBlock) {
+	if (!pBlock)
+		return;
+	lock_guard<mutex> lock(_mutex);
+	((Free*)pBlock)->pNext = _pFree;
+	_pFree = (Free*)pBlock;
+	--_used;
+}
+
+
+} // namespace Mona
@@ -21,13 +21,33 @@ This file is a part of Mona.
 #include "Mona/Socket.h"
 #include "Mona/SocketManager.h"
 #include "Mona/SocketSender.h"
+#include "Mona/Memory.h"
+
+#define BATCH_MAXIMUM	64
+#define IOVECS_MAXIMUM	256
+#define OVERFLOW_SIZE	0xFFFF // maximum datagram size
+#define GSO_SEGMENTS	64 // UDP_MAX_SEGMENTS of the kernel
+#define GSO_MAXIMUM		65000 // bytes by GSO message (UDP payload limit less some margin)
+
+#if _OS == _OS_LINUX
+#include <netinet/udp.h>
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT		103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO			104
+#endif
+#endif
 
 using namespace std;
 
 namespace Mona {
 
+// data waiting in the send queues of the sockets
+static Memory::Counter Queues("socketQueues");
+
 
-Socket::Socket(const SocketManager& manager, int type) : Expirable<Socket>(this), _type(type),_initialized(false), _managed(false), manager(manager), _sockfd(NET_INVALID_SOCKET), _writing(false) {}
+Socket::Socket(const SocketManager& manager, int type) : Expirable<Socket>(this), _type(type),_initialized(false), _managed(false), manager(manager), _sockfd(NET_INVALID_SOCKET), _writing(false), _batch(0), _batchDeferred(false), _gso(false), _gro(false), _ppSocket(NULL), _reactor(0), _readPending(false), _edgeTriggered(false), _readsInReactor(false), _readEvents(0), _queueing(0), _queueMaximum(0), _congested(false) {}
 
 Socket::~Socket() {
 	close();
@@ -50,7 +70,10 @@ void Socket::close() {
 		return;
 	_managed = false;
 	manager.remove(*this);
+	Queues.add(-(Int64)_queueing, -(Int32)_senders.size());
 	_senders.clear();
+	_queueing = 0;
+	_congested = false;
 }
 
 bool Socket::init(Exception& ex, IPAddress::Family family) {
@@ -190,6 +213,46 @@ int Socket::sendBytes(Exception& ex, const void* buffer, int length, int flags)
 	return rc;
 }
 
+int Socket::sendBytes(Exception& ex, const Part* parts, UInt32 count, int flags) {
+	ASSERT_RETURN(_initialized == true, 0)
+	if (count > IOVECS_MAXIMUM)
+		count = IOVECS_MAXIMUM;
+	int rc;
+#if defined(_WIN32)
+	WSABUF bufs[IOVECS_MAXIMUM];
+	for (UInt32 i = 0; i < count; ++i) {
+		bufs[i].buf = (char*)parts[i].data;
+		bufs[i].len = parts[i].size;
+	}
+	DWORD sent(0);
+	do {
+		rc = ::WSASend(_sockfd, bufs, count, &sent, flags, NULL, NULL);
+	} while (rc != 0 && Net::LastError() == NET_EINTR);
+	if (rc == 0)
+		rc = (int)sent;
+#else
+	iovec iovs[IOVECS_MAXIMUM];
+	for (UInt32 i = 0; i < count; ++i) {
+		iovs[i].iov_base = (void*)parts[i].data;
+		iovs[i].iov_len = parts[i].size;
+	}
+	msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iovs;
+	msg.msg_iovlen = count;
+	do {
+		rc = ::sendmsg(_sockfd, &msg, flags);
+	} while (rc < 0 && Net::LastError() == NET_EINTR);
+#endif
+	if (rc < 0) {
+		int err = Net::LastError();
+		if (err == NET_EAGAIN || err == NET_EWOULDBLOCK)
+			return 0;
+		Net::SetError(ex, err);
+	}
+	return rc;
+}
+
 
 int Socket::receiveBytes(Exception& ex, void* buffer, int length, int flags) {
 	int rc;
@@ -207,6 +270,62 @@ int Socket::receiveBytes(Exception& ex, void* buffer, int length, int flags) {
 }
 
 
+static THREAD_LOCAL UInt8 Overflow[OVERFLOW_SIZE];
+
+int Socket::receive(Exception& ex, Buffer& buffer, UInt32 offset, SocketAddress* pAddress) {
+	ASSERT_RETURN(_initialized == true, -1)
+	if (offset > buffer.size())
+		offset = buffer.size();
+	UInt32 room(buffer.size() - offset);
+	struct sockaddr_in6	name; // large enough for IPv4 and IPv6
+	int rc;
+#if defined(_WIN32)
+	WSABUF bufs[2];
+	bufs[0].buf = reinterpret_cast<char*>(buffer.data() + offset);
+	bufs[0].len = room;
+	bufs[1].buf = reinterpret_cast<char*>(Overflow);
+	bufs[1].len = sizeof(Overflow);
+	DWORD received(0), flags(0);
+	int nameLen(sizeof(name));
+	do {
+		// socket is already non-blocking with WSAAsyncSelect
+		rc = ::WSARecvFrom(_sockfd, bufs, 2, &received, &flags, pAddress ? reinterpret_cast<struct sockaddr*>(&name) : NULL, pAddress ? &nameLen : NULL, NULL, NULL);
+	} while (rc != 0 && Net::LastError() == NET_EINTR);
+	if (rc == 0)
+		rc = (int)received;
+#else
+	iovec iovs[2];
+	iovs[0].iov_base = buffer.data() + offset;
+	iovs[0].iov_len = room;
+	iovs[1].iov_base = Overflow;
+	iovs[1].iov_len = sizeof(Overflow);
+	msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	if (pAddress) {
+		msg.msg_name = &name;
+		msg.msg_namelen = sizeof(name);
+	}
+	msg.msg_iov = iovs;
+	msg.msg_iovlen = 2;
+	do {
+		rc = ::recvmsg(_sockfd, &msg, MSG_DONTWAIT);
+	} while (rc < 0 && Net::LastError() == NET_EINTR);
+#endif
+	if (rc < 0) {
+		int err = Net::LastError();
+		if (err != NET_EAGAIN && err != NET_EWOULDBLOCK)
+			Net::SetError(ex, err);
+		return -1;
+	}
+	if (pAddress)
+		pAddress->set(*reinterpret_cast<struct sockaddr*>(&name));
+	buffer.resize(offset + rc, true);
+	if ((UInt32)rc > room)
+		memcpy(buffer.data() + offset + room, Overflow, rc - room);
+	return rc;
+}
+
+
 int Socket::sendTo(Exception& ex, const void* buffer, int length, const SocketAddress& address, int flags) {
 	if (!_initialized && !init(ex, address.family()))
 		return 0;
@@ -253,6 +372,235 @@ int Socket::receiveFrom(Exception& ex, void* buffer, int length, SocketAddress&
 	return rc;
 }
 
+bool Socket::setBatch(UInt16 count) {
+	if (count < 2)
+		count = 0;
+#if _OS == _OS_LINUX
+	else if (count > BATCH_MAXIMUM)
+		count = BATCH_MAXIMUM;
+	lock_guard<mutex> lock(_mutexAsync);
+	_batch = count;
+	return true;
+#else
+	_batch = 0;
+	return count == 0;
+#endif
+}
+
+bool Socket::setGSO(bool enable) {
+#if _OS == _OS_LINUX
+	if (!_initialized)
+		return false;
+	if (enable) {
+		// a socket gso_size of 0 keeps the segmentation by message (cmsg), it just checks that the kernel knows UDP_SEGMENT
+		Exception ex;
+		setOption(ex, IPPROTO_UDP, UDP_SEGMENT, 0);
+		if (ex)
+			return false;
+	}
+	lock_guard<mutex> lock(_mutexAsync);
+	_gso = enable;
+	return true;
+#else
+	return !enable;
+#endif
+}
+
+bool Socket::setGRO(bool enable) {
+#if _OS == _OS_LINUX
+	if (!_initialized)
+		return false;
+	Exception ex;
+	setOption(ex, IPPROTO_UDP, UDP_GRO, enable ? 1 : 0);
+	if (ex)
+		return false;
+	_gro = enable;
+	return true;
+#else
+	return !enable;
+#endif
+}
+
+int Socket::receiveFrom(Exception& ex, Buffer** buffers, SocketAddress* addresses, int count, UInt16* segments) {
+	ASSERT_RETURN(_initialized == true, 0)
+#if _OS == _OS_LINUX
+	if (count > BATCH_MAXIMUM)
+		count = BATCH_MAXIMUM;
+	mmsghdr				msgs[BATCH_MAXIMUM];
+	iovec				iovs[BATCH_MAXIMUM];
+	struct sockaddr_in6	names[BATCH_MAXIMUM]; // large enough for IPv4 and IPv6
+	char				controls[BATCH_MAXIMUM][CMSG_SPACE(sizeof(int))];
+	memset(msgs, 0, count*sizeof(mmsghdr));
+	for (int i = 0; i < count; ++i) {
+		iovs[i].iov_base = buffers[i]->data();
+		iovs[i].iov_len = buffers[i]->size();
+		msgs[i].msg_hdr.msg_name = &names[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(names[i]);
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		if (segments) {
+			msgs[i].msg_hdr.msg_control = controls[i];
+			msgs[i].msg_hdr.msg_controllen = sizeof(controls[i]);
+		}
+	}
+	int rc;
+	do {
+		rc = ::recvmmsg(_sockfd, msgs, count, MSG_DONTWAIT, NULL);
+	} while (rc < 0 && Net::LastError() == NET_EINTR);
+	if (rc < 0) {
+		int err = Net::LastError();
+		if (err != NET_EAGAIN && err != NET_EWOULDBLOCK)
+			Net::SetError(ex, err);
+		return 0;
+	}
+	for (int i = 0; i < rc; ++i) {
+		addresses[i].set(*reinterpret_cast<struct sockaddr*>(&names[i]));
+		if (msgs[i].msg_hdr.msg_flags&MSG_TRUNC) {
+			ex.set(Exception::SOCKET, "Datagram from ", addresses[i].toString(), " truncated to ", msgs[i].msg_len, " bytes");
+			buffers[i]->resize(0, false);
+		} else
+			buffers[i]->resize(msgs[i].msg_len, true);
+		if (!segments)
+			continue;
+		segments[i] = 0;
+		for (struct cmsghdr* pCMsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); pCMsg; pCMsg = CMSG_NXTHDR(&msgs[i].msg_hdr, pCMsg)) {
+			if (pCMsg->cmsg_level == IPPROTO_UDP && pCMsg->cmsg_type == UDP_GRO) {
+				int size;
+				memcpy(&size, CMSG_DATA(pCMsg), sizeof(size));
+				segments[i] = (UInt16)size;
+			}
+		}
+	}
+	return rc;
+#else
+	ex.set(Exception::SOCKET, "Batched datagram reception unsupported on this platform");
+	return 0;
+#endif
+}
+
+bool Socket::deferBatch() {
+	// the socket can be deleted before that the PoolThread runs out of jobs
+	shared_ptr<Expirable<Socket>> pExpirable(make_shared<Expirable<Socket>>());
+	shareThis(*pExpirable);
+	return PoolThread::Defer([pExpirable]() {
+		unique_lock<mutex> lock;
+		Socket* pSocket = pExpirable->safeThis(lock);
+		if (pSocket)
+			pSocket->flushBatch();
+	});
+}
+
+void Socket::flushBatch() {
+	Exception ex;
+	{
+		lock_guard<mutex> lock(_mutexAsync);
+		_batchDeferred = false;
+		if (_writing || _senders.empty())
+			return; // the writable event will flush the senders
+		if (!sendBatch(ex))
+			manageWrite(ex); // socket buffer full, wait writable event
+	}
+	if (ex)
+		onError(ex.error());
+}
+
+bool Socket::sendBatch(Exception& ex) {
+#if _OS == _OS_LINUX
+	mmsghdr					msgs[BATCH_MAXIMUM];
+	iovec					iovs[IOVECS_MAXIMUM];
+	const SocketAddress*	destinations[BATCH_MAXIMUM];
+	UInt8					datagrams[BATCH_MAXIMUM]; // datagrams by message, more than one with GSO
+	char					controls[BATCH_MAXIMUM][CMSG_SPACE(sizeof(UInt16))];
+	while (!_senders.empty()) {
+		int count(0), iovCount(0);
+		for (deque<shared_ptr<SocketSender>>::iterator it = _senders.begin(); it != _senders.end() && iovCount < IOVECS_MAXIMUM; ++it) {
+			SocketSender& sender(**it);
+			if (!sender.available())
+				continue;
+			UInt32 size(sender.size() - sender._position);
+			const SocketAddress* pAddress(sender.destination());
+			if (_gso && count > 0) {
+				// GSO, append it as a new segment of the previous message if it goes to the same destination,
+				// and if all the previous segments have the segment size (only the last one can be smaller)
+				msghdr& previous(msgs[count - 1].msg_hdr);
+				size_t segment(previous.msg_iov[0].iov_len);
+				if (datagrams[count - 1] < GSO_SEGMENTS && size <= segment && previous.msg_iov[previous.msg_iovlen - 1].iov_len == segment && (datagrams[count - 1] + 1)*segment <= GSO_MAXIMUM &&
+					(pAddress ? (destinations[count - 1] && *pAddress == *destinations[count - 1]) : !destinations[count - 1])) {
+					iovs[iovCount].iov_base = (void*)(sender.data() + sender._position);
+					iovs[iovCount++].iov_len = size;
+					++previous.msg_iovlen; // iovecs of the last message are contiguous
+					++datagrams[count - 1];
+					continue;
+				}
+			}
+			if (count == _batch)
+				break;
+			iovs[iovCount].iov_base = (void*)(sender.data() + sender._position);
+			iovs[iovCount].iov_len = size;
+			memset(&msgs[count], 0, sizeof(mmsghdr));
+			if (pAddress) {
+				msgs[count].msg_hdr.msg_name = (void*)&pAddress->addr();
+				msgs[count].msg_hdr.msg_namelen = sizeof(pAddress->addr());
+			}
+			msgs[count].msg_hdr.msg_iov = &iovs[iovCount++];
+			msgs[count].msg_hdr.msg_iovlen = 1;
+			destinations[count] = pAddress;
+			datagrams[count++] = 1;
+		}
+		for (int i = 0; i < count; ++i) {
+			if (datagrams[i] < 2)
+				continue;
+			msghdr& msg(msgs[i].msg_hdr);
+			msg.msg_control = controls[i];
+			msg.msg_controllen = sizeof(controls[i]);
+			struct cmsghdr* pCMsg = CMSG_FIRSTHDR(&msg);
+			pCMsg->cmsg_level = IPPROTO_UDP;
+			pCMsg->cmsg_type = UDP_SEGMENT;
+			pCMsg->cmsg_len = CMSG_LEN(sizeof(UInt16));
+			UInt16 segment((UInt16)msg.msg_iov[0].iov_len);
+			memcpy(CMSG_DATA(pCMsg), &segment, sizeof(segment));
+		}
+		int sent(0);
+		if (count > 0) {
+			do {
+				sent = ::sendmmsg(_sockfd, msgs, count, 0);
+			} while (sent < 0 && Net::LastError() == NET_EINTR);
+			if (sent < 0) {
+				int err = Net::LastError();
+				if (err == NET_EAGAIN || err == NET_EWOULDBLOCK)
+					return false;
+				if (datagrams[0] > 1 && (err == EIO || err == EINVAL)) {
+					// GSO refused for this route (no checksum offload, segment larger than the MTU...), send datagrams one by one
+					_gso = false;
+					continue;
+				}
+				// the first message has failed, terminate its datagrams as SocketSender::flush does
+				Net::SetError(ex, err);
+				sent = 1;
+			}
+		}
+		// remove sent datagrams (and empty senders between them)
+		int remaining(0);
+		for (int i = 0; i < sent; ++i)
+			remaining += datagrams[i];
+		while (!_senders.empty() && (remaining > 0 || !_senders.front()->available())) {
+			SocketSender& sender(*_senders.front());
+			if (sender.available()) {
+				sender._position = sender.size();
+				--remaining;
+			}
+			unqueue();
+		}
+	}
+#endif
+	return true;
+}
+
+void Socket::retainSenders() {
+	for (const shared_ptr<SocketSender>& pSender : _senders)
+		pSender->retain(poolBuffers());
+}
+
 SocketAddress& Socket::address(Exception& ex, SocketAddress& address) const {
 	ASSERT_RETURN(_initialized == true, address)
 	char	addressBuffer[IPAddress::MAX_ADDRESS_LENGTH];
@@ -325,6 +673,37 @@ int Socket::ioctl(Exception& ex,NET_IOCTLREQUEST request,int value) {
 	return value;
 }
 
+void Socket::queue(const shared_ptr<SocketSender>& pSender) {
+	_senders.emplace_back(pSender);
+	Queues.add(0, 1);
+	updateQueue(pSender->_queued = pSender->pending(), 0);
+}
+
+void Socket::unqueue() {
+	UInt32 queued(_senders.front()->_queued);
+	_senders.pop_front();
+	Queues.add(0, -1);
+	updateQueue(0, queued);
+}
+
+void Socket::updateQueue(UInt32 added, UInt32 removed) {
+	_queueing += added;
+	_queueing -= removed;
+	Queues.add((Int64)added - removed);
+	if (!_queueMaximum)
+		return;
+	// hysteresis, to not notify at each sender
+	if (_congested) {
+		if (_queueing > _queueMaximum / 2)
+			return;
+		_congested = false;
+		onWriteDrained();
+	} else if (_queueing >= _queueMaximum) {
+		_congested = true;
+		onWriteBlocked();
+	}
+}
+
 void Socket::manageWrite(Exception& ex) {
 	if (!_writing) {
 		_writing = true;
@@ -336,12 +715,19 @@ void Socket::manageWrite(Exception& ex) {
 void Socket::flushSenders(Exception& ex) {
 	lock_guard<mutex>	lock(_mutexAsync);
 	while (!_senders.empty()) {
-		if (!_senders.front()->flush(ex,*this)) {
+		if (_batch ? !sendBatch(ex) : !_senders.front()->flush(ex,*this)) {
+			if (!_batch) {
+				// count just what remains to send of the first sender
+				SocketSender& sender(*_senders.front());
+				UInt32 queued(sender._queued);
+				updateQueue(sender._queued = sender.pending(), queued);
+			}
 			if (!_writing)
 				_writing = manager.startWrite(ex,*this);
 			return;
 		}
-		_senders.pop_front();
+		if (!_batch)
+			unqueue();
 	}
 	if (_writing && _senders.empty())
 		_writing = !manager.stopWrite(ex, *this);
@@ -19,6 +19,8 @@ This file is a part of Mona.
 
 #include "Mona/SocketManager.h"
 #include "Mona/Logs.h"
+#include "Mona/Util.h"
+#include "Mona/String.h"
 #if !defined(_WIN32)
 #include "sys/epoll.h"
 #endif
@@ -35,95 +37,156 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
 #endif
 
 
-SocketManager::SocketManager(TaskHandler& handler, const PoolBuffers& poolBuffers, PoolThreads& poolThreads, UInt32 bufferSize, const string& name) : poolBuffers(poolBuffers),
-    _fakeSocket(*this), _selfHandler(false), poolThreads(poolThreads), _eventFD(0), _sockfd(NET_INVALID_SOCKET), _eventSystem(0), bufferSize(bufferSize), Startable(name), Task(handler), _currentEvent(0), _currentError(0), _eventInit(false), _ppSocket(NULL) {
-	_fakeSocket._initialized = true;
+SocketManager::SocketManager(TaskHandler& handler, const PoolBuffers& poolBuffers, PoolThreads& poolThreads, UInt32 bufferSize, const string& name, UInt16 reactors) : poolBuffers(poolBuffers),
+	poolThreads(poolThreads), bufferSize(bufferSize), _name(name), _running(false), _edgeTriggered(false) {
+	if (reactors == 0)
+		reactors = Util::ProcessorCount();
+	string reactorName;
+	for (UInt16 i = 0; i < reactors; ++i)
+		_reactors.emplace_back(new Reactor(*this, handler, i, reactors>1 ? String::Format(reactorName, name, i) : name));
 }
-SocketManager::SocketManager(const PoolBuffers& poolBuffers, PoolThreads& poolThreads, UInt32 bufferSize, const string& name) : poolBuffers(poolBuffers),
-    _fakeSocket(*this), _selfHandler(true), poolThreads(poolThreads), _eventFD(0), _sockfd(NET_INVALID_SOCKET), _eventSystem(0), bufferSize(bufferSize), Startable(name), Task((TaskHandler&)*this), _currentEvent(0), _currentError(0), _eventInit(false), _ppSocket(NULL) {
-	_fakeSocket._initialized = true;
+SocketManager::SocketManager(const PoolBuffers& poolBuffers, PoolThreads& poolThreads, UInt32 bufferSize, const string& name, UInt16 reactors) : poolBuffers(poolBuffers),
+	poolThreads(poolThreads), bufferSize(bufferSize), _name(name), _running(false), _edgeTriggered(false) {
+	if (reactors == 0)
+		reactors = Util::ProcessorCount();
+	string reactorName;
+	for (UInt16 i = 0; i < reactors; ++i)
+		_reactors.emplace_back(new Reactor(*this, i, reactors>1 ? String::Format(reactorName, name, i) : name));
 }
 
 bool SocketManager::start(Exception& ex) {
-	TaskHandler::start();
-	return Startable::start(ex);
+	if (_running)
+		return true;
+	_running = true;
+	for (unique_ptr<Reactor>& pReactor : _reactors) {
+		if (!pReactor->start(ex)) {
+			stop();
+			return false;
+		}
+	}
+	return true;
 }
 
 void SocketManager::stop() {
-	if (!Startable::running())
+	if (!_running)
 		return;
-	TaskHandler::stop();
-	_eventInit.wait();
+	_running = false;
 	clear();
+	for (unique_ptr<Reactor>& pReactor : _reactors)
+		pReactor->stop();
+}
+
+
+bool SocketManager::setEdgeTriggered(bool enable) {
+	if (_running)
+		return false;
 #if defined(_WIN32)
-	if (_eventSystem > 0)
-		PostMessage(_eventSystem, WM_QUIT, 0, 0);
+	return !enable;
 #else
-	if (_eventSystem > 0)
-		::close(_eventFD);
+	_edgeTriggered = enable;
+	return true;
 #endif
-	Startable::stop();
-	_eventInit.reset();
 }
 
+UInt64 SocketManager::wakeUps() const {
+	UInt64 result(0);
+	for (const unique_ptr<Reactor>& pReactor : _reactors)
+		result += pReactor->_wakeUps;
+	return result;
+}
+
+UInt64 SocketManager::events() const {
+	UInt64 result(0);
+	for (const unique_ptr<Reactor>& pReactor : _reactors)
+		result += pReactor->_events;
+	return result;
+}
 
 
 void SocketManager::clear() {
-	lock_guard<mutex> lock(_mutex);
-	for(auto& it : _sockets) {
-		if(_eventSystem>0) {
+	_sockets.clear([this](NET_SOCKET sockfd, unique_ptr<Socket>* ppSocket) {
+		Reactor& reactor(*_reactors[(*ppSocket)->_reactor]);
+		lock_guard<mutex> lockReactor(reactor._mutex);
+		// release before to give the holder to the reactor thread, which deletes it
+		(*ppSocket)->_ppSocket = NULL;
+		ppSocket->release();
+		if(reactor._eventSystem>0) {
 #if defined(_WIN32)
-			WSAAsyncSelect(it.first,_eventSystem,0,0);
-			PostMessage(_eventSystem,0,(WPARAM)it.second,0);
+			WSAAsyncSelect(sockfd,reactor._eventSystem,0,0);
+			PostMessage(reactor._eventSystem,0,(WPARAM)ppSocket,0);
 #else
-            write(_eventFD,&it.second,sizeof(it.second));
+			write(reactor._eventFD,&ppSocket,sizeof(ppSocket));
 #endif
 		}
-	}
-	_counter = 0;
-	_sockets.clear();
+		reactor._counter = 0;
+	});
 }
 
 
 bool SocketManager::add(Exception& ex,Socket& socket) const {
-	if (!Startable::running()) {
-		ex.set(Exception::SOCKET, name(), "is not running");
+	if (!_running) {
+		ex.set(Exception::SOCKET, _name, " is not running");
 		return false;
 	}
 
-	_eventInit.wait();
+	// assign the socket to the less loaded reactor
+	Reactor* pReactor(NULL);
+	for (const unique_ptr<Reactor>& pCandidate : _reactors) {
+		if (!pReactor || pCandidate->_counter < pReactor->_counter)
+			pReactor = pCandidate.get();
+	}
+
+	pReactor->_eventInit.wait();
 
-	if(_eventSystem==0) {
-		ex.set(Exception::SOCKET, name(), " hasn't been able to start, impossible to manage sockets");
+	if(pReactor->_eventSystem==0) {
+		ex.set(Exception::SOCKET, pReactor->Startable::name(), " hasn't been able to start, impossible to manage sockets");
 		return false;
 	}
 
     NET_SOCKET sockfd = socket._sockfd;
 
 
-	lock_guard<mutex> lock(_mutex);
-
-	auto& it = _sockets.lower_bound(sockfd);
-	if (it != _sockets.end() && it->first == sockfd)
-		return true; // already managed
-	
-	
 	unique_ptr<Socket>* ppSocket = new unique_ptr<Socket>(&socket);
+	if (!_sockets.insert(sockfd, ppSocket)) {
+		ppSocket->release();
+		delete ppSocket;
+		return true; // already managed
+	}
+	// ready before the first event
+	socket._reactor = pReactor->index;
+	socket._ppSocket = ppSocket;
+	socket._readsInReactor = !pReactor->_selfHandler && socket.readsInReactor();
+
 #if defined(_WIN32)
 	int flags = FD_ACCEPT | FD_CLOSE | FD_READ;
-	if (WSAAsyncSelect(sockfd, _eventSystem, 104, flags) != 0) {
+	if (WSAAsyncSelect(sockfd, pReactor->_eventSystem, 104, flags) != 0) {
+		socket._ppSocket = NULL;
+		_sockets.erase(sockfd);
 		ppSocket->release();
 		delete ppSocket;
 		Net::SetError(ex);
 		return false;
 	}
 #else
+	socket._readPending = false;
+	socket._readEvents = 0;
+	socket._edgeTriggered = _edgeTriggered && socket.drains();
 	epoll_event event;
 	event.events = EPOLLIN | EPOLLRDHUP;
-	 event.data.fd = sockfd;
-	 event.data.ptr = ppSocket;
-	 int res = epoll_ctl(_eventSystem, EPOLL_CTL_ADD,sockfd, &event);
+	if (socket._edgeTriggered) {
+		event.events |= EPOLLET;
+		// a stream socket signals write space only after a full buffer, so can be polled for writing one time for all,
+		// whereas a datagram socket signals it after each datagram sent, it stays polled for writing only when required
+		if (socket._type == SOCK_STREAM)
+			event.events |= EPOLLOUT;
+	}
+	else if (!pReactor->_selfHandler && !socket._readsInReactor)
+		event.events |= EPOLLONESHOT; // rearmed after each read handled
+	event.data.ptr = ppSocket;
+	int res = epoll_ctl(pReactor->_eventSystem, EPOLL_CTL_ADD,sockfd, &event);
 	if(res<0) {
+		socket._ppSocket = NULL;
+		_sockets.erase(sockfd);
 		ppSocket->release();
 		delete ppSocket;
         Net::SetError(ex);
@@ -131,9 +194,7 @@ bool SocketManager::add(Exception& ex,Socket& socket) const {
 	}
 #endif
 
-	++_counter;
-	socket._ppSocket = ppSocket;
-	_sockets.emplace_hint(it, sockfd, ppSocket);
+	++pReactor->_counter;
 
 	if(bufferSize>0) {
 		socket.setReceiveBufferSize(ex, bufferSize);
@@ -143,38 +204,29 @@ bool SocketManager::add(Exception& ex,Socket& socket) const {
 	return true;
 }
 
-bool SocketManager::startWrite(Exception& ex, Socket& socket) const {
+bool SocketManager::update(Exception& ex, Socket& socket, bool writing) const {
+	const Reactor& reactor(*_reactors[socket._reactor]);
 #if defined(_WIN32)
-	if (WSAAsyncSelect(socket._sockfd, _eventSystem, 104, FD_ACCEPT | FD_CLOSE | FD_READ | FD_WRITE) != 0) {
+	if (WSAAsyncSelect(socket._sockfd, reactor._eventSystem, 104, FD_ACCEPT | FD_CLOSE | FD_READ | (writing ? FD_WRITE : 0)) != 0) {
 		Net::SetError(ex);
 		return false;
 	}
 #else
 	epoll_event event;
-	event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP;
-	event.data.fd = socket._sockfd;
-	event.data.ptr = socket._ppSocket;
-    int res = epoll_ctl(_eventSystem, EPOLL_CTL_MOD, event.data.fd, &event);
-	if(res<0) {
-        Net::SetError(ex);
-		return false;
-	}
-#endif
-	return true;
-}
-
-bool SocketManager::stopWrite(Exception& ex, Socket& socket) const {
-#if defined(_WIN32)
-	if (WSAAsyncSelect(socket._sockfd, _eventSystem, 104, FD_ACCEPT | FD_CLOSE | FD_READ) != 0) {
-		Net::SetError(ex);
-		return false;
+	event.events = writing ? EPOLLOUT : 0;
+	if (socket._edgeTriggered) {
+		if (socket._type == SOCK_STREAM)
+			return true; // always polled for reading and writing
+		event.events |= EPOLLIN | EPOLLRDHUP | EPOLLET;
+	} else if (reactor._selfHandler || socket._readsInReactor)
+		event.events |= EPOLLIN | EPOLLRDHUP;
+	else {
+		event.events |= EPOLLONESHOT;
+		if (!socket._readPending)
+			event.events |= EPOLLIN | EPOLLRDHUP;
 	}
-#else
-	epoll_event event;
-	event.events = EPOLLIN | EPOLLRDHUP;
-	event.data.fd = socket._sockfd;
 	event.data.ptr = socket._ppSocket;
-    int res = epoll_ctl(_eventSystem, EPOLL_CTL_MOD, event.data.fd, &event);
+    int res = epoll_ctl(reactor._eventSystem, EPOLL_CTL_MOD, socket._sockfd, &event);
 	if(res<0) {
         Net::SetError(ex);
 		return false;
@@ -185,72 +237,201 @@ bool SocketManager::stopWrite(Exception& ex, Socket& socket) const {
 
 
 void SocketManager::remove(Socket& socket) const {
-	lock_guard<mutex>	lock(_mutex);
-	auto& it = _sockets.find(socket._sockfd);
-	if(it == _sockets.end())
+	// the one which erases it from the table owns the holder (against a concurrent clear)
+	unique_ptr<Socket>* ppSocket(_sockets.erase(socket._sockfd));
+	if(!ppSocket)
 		return;
 
-	_eventInit.wait();
+	Reactor& reactor(*_reactors[socket._reactor]);
+	reactor._eventInit.wait();
 
-	if(_eventSystem>0) {
+	// protect a flush of this socket in progress in the reactor thread
+	lock_guard<mutex>	lockReactor(reactor._mutex);
+	// release before to give the holder to the reactor thread, which deletes it (events always queued will ignore it)
+	ppSocket->release();
+	socket._ppSocket = NULL;
+	if(reactor._eventSystem>0) {
 #if defined(_WIN32)
-		WSAAsyncSelect(it->first,_eventSystem,0,0);
-		PostMessage(_eventSystem,0,(WPARAM)it->second,0);
+		WSAAsyncSelect(socket._sockfd,reactor._eventSystem,0,0);
+		PostMessage(reactor._eventSystem,0,(WPARAM)ppSocket,0);
 #else
 		epoll_event event; // Will be ignored by the epoll_ctl call, but is required to work with kernel < 2.6.9
-		epoll_ctl(_eventSystem, EPOLL_CTL_DEL, it->first,&event);
-		write(_eventFD,&it->second,sizeof(it->second));
+		epoll_ctl(reactor._eventSystem, EPOLL_CTL_DEL, socket._sockfd,&event);
+		write(reactor._eventFD,&ppSocket,sizeof(ppSocket));
 #endif
 	}
 
-	--_counter;
-	socket._ppSocket = NULL;
-	_sockets.erase(it);
+	--reactor._counter;
+}
+
+
+SocketManager::Reactor::Reactor(SocketManager& manager, UInt16 index, const string& name) : index(index), _manager(manager), _handler(*this),
+	_fakeSocket(manager), _selfHandler(true), _eventFD(0), _eventSystem(0), Startable(name), Task((TaskHandler&)*this), _counter(0), _eventInit(false), _wakeUps(0), _events(0) {
+	_fakeSocket._initialized = true;
+}
+SocketManager::Reactor::Reactor(SocketManager& manager, TaskHandler& handler, UInt16 index, const string& name) : index(index), _manager(manager), _handler(handler),
+	_fakeSocket(manager), _selfHandler(false), _eventFD(0), _eventSystem(0), Startable(name), Task(handler), _counter(0), _eventInit(false), _wakeUps(0), _events(0) {
+	_fakeSocket._initialized = true;
+}
+
+bool SocketManager::Reactor::start(Exception& ex) {
+	TaskHandler::start();
+	return Startable::start(ex);
 }
 
-void SocketManager::handle(Exception& ex) {
-	if (_ex) {
+void SocketManager::Reactor::stop() {
+	if (!Startable::running())
+		return;
+	TaskHandler::stop();
+	_eventInit.wait();
+#if defined(_WIN32)
+	if (_eventSystem > 0)
+		PostMessage(_eventSystem, WM_QUIT, 0, 0);
+#else
+	if (_eventSystem > 0)
+		::close(_eventFD);
+#endif
+	Startable::stop();
+	_eventInit.reset();
+}
+
+void SocketManager::Reactor::handle(Exception& ex) {
+	// just to report a starting error of the reactor
+	if (_ex)
 		ex.set(_ex);
+}
+
+void SocketManager::Reactor::dispatch(unique_ptr<Socket>* ppSocket, NET_SOCKET sockfd, UInt32 event, int error) {
+	if (_selfHandler) {
+		process(SocketEvent(ppSocket, sockfd, event, error));
 		return;
 	}
-
-	Socket* pSocket(NULL);
-	if (_ppSocket)
-		pSocket = _ppSocket->get();
-	if (!pSocket) {
-		auto& it = _sockets.find(_sockfd);
-		if(it==_sockets.end())
+	{
+		// protected for _ppSocket access
+		lock_guard<mutex> lock(_mutex);
+#if defined(_WIN32)
+		// a holder is released by this message loop, so not during this call
+		unique_ptr<Socket>* ppFound(_manager._sockets.find(sockfd));
+		Socket* pSocket(ppFound ? ppFound->get() : NULL);
+#else
+		Socket* pSocket(ppSocket->get());
+#endif
+		if (!pSocket)
+			return; // removed
+		if (pSocket->_readsInReactor) {
+			// read here, the lock delays its removal (and so its deletion) after the reading
+			process(SocketEvent(ppSocket, sockfd, event, error));
 			return;
-		pSocket = it->second->get();
+		}
+#if !defined(_WIN32)
+		if (pSocket->_edgeTriggered ? pSocket->_readEvents++ > 0 : pSocket->_readPending.exchange(true))
+			return; // a read is already pending (edge-triggered it will read again, else the socket will be rearmed after it)
+#endif
 	}
-	if (!pSocket)
+	if (!_pEvents)
+		_pEvents.reset(new SocketEvents(*this));
+	_pEvents->events.emplace_back(ppSocket, sockfd, event, error);
+}
+
+void SocketManager::Reactor::release(unique_ptr<Socket>* ppSocket) {
+	if (_selfHandler) {
+		ppSocket->release(); // don't delete the pSocket!
+		delete ppSocket;
 		return;
+	}
+	// deletion of the holder must happen after the handling of its events queued
+	if (!_pEvents)
+		_pEvents.reset(new SocketEvents(*this));
+	_pEvents->releasings.emplace_back(ppSocket);
+}
 
-	if(_currentError!=0) {
-		Exception curEx;
-		Net::SetError(curEx, _currentError);
-		pSocket->onError(curEx.error());
+void SocketManager::Reactor::flush(UInt32 count) {
+	++_wakeUps;
+	_events += count;
+	if (!_pEvents)
 		return;
+	_handler.postHandle(_pEvents);
+	_pEvents.reset();
+}
+
+void SocketManager::Reactor::process(const SocketEvent& event) {
+	Socket* pSocket(NULL);
+	if (event.ppSocket)
+		pSocket = event.ppSocket->get();
+	else {
+		// holders are deleted after the handling of the events queued before their removal
+		unique_ptr<Socket>* ppSocket(_manager._sockets.find(event.sockfd));
+		if(!ppSocket)
+			return;
+		pSocket = ppSocket->get();
 	}
+	if (!pSocket)
+		return;
 
-	/// now, read or accept event!
+	UInt32 reads(pSocket->_readEvents); // edge-triggered events handled by this call
+	int error(event.error);
+	for (;;) {
+		if(error!=0) {
+			Exception curEx;
+			Net::SetError(curEx, error);
+			pSocket->onError(curEx.error());
+		} else {
+			/// now, read or accept event!
+#if defined(_WIN32)
+			Exception exSkip;
+			if(event.event==FD_READ && pSocket->available(exSkip)==0) // In the linux case, when _currentEvent==SELECT_READ with 0 bytes it's a ACCEPT event!
+				return;
+#endif
+			Exception socketEx;
+			pSocket->onReadable(socketEx);
+			if (socketEx)
+				pSocket->onError(socketEx.error());
+		}
 
 #if defined(_WIN32)
-	if(_currentEvent==FD_READ && pSocket->available(_exSkip)==0) // In the linux case, when _currentEvent==SELECT_READ with 0 bytes it's a ACCEPT event!
 		return;
+#else
+		if (_selfHandler || !event.ppSocket->get() || pSocket->_readsInReactor)
+			return; // nothing to rearm, or socket removed during the handling
+		if (!pSocket->_edgeTriggered)
+			break;
+		// nothing to rearm, but the edges received during the handling have not been posted: read again
+		if ((pSocket->_readEvents -= reads) == 0)
+			return;
+		reads = pSocket->_readEvents;
+		error = 0;
 #endif
-	Exception socketEx;
-	pSocket->onReadable(socketEx);
-	if (socketEx)
-		pSocket->onError(socketEx.error());
+	}
+
+#if !defined(_WIN32)
+	pSocket->_readPending = false;
+	Exception exRearm;
+	_manager.update(exRearm, *pSocket, pSocket->_writing);
+#endif
+}
+
+
+SocketManager::SocketEvents::SocketEvents(Reactor& reactor) : Task(reactor._handler), _reactor(reactor) {
+}
+
+SocketManager::SocketEvents::~SocketEvents() {
+	for (unique_ptr<Socket>* ppSocket : releasings) {
+		ppSocket->release(); // don't delete the pSocket!
+		delete ppSocket;
+	}
 }
 
-void SocketManager::requestHandle() {
+void SocketManager::SocketEvents::handle(Exception& ex) {
+	for (const SocketEvent& event : events)
+		_reactor.process(event);
+}
+
+void SocketManager::Reactor::requestHandle() {
 	Exception ex;
 	giveHandle(ex);
 }
 
-void SocketManager::run(Exception& exc) {
+void SocketManager::Reactor::run(Exception& exc) {
 	Exception& ex(_selfHandler ? exc : _ex);
 	const char* name = Startable::name().c_str();
 #if defined(_WIN32)
@@ -293,39 +474,51 @@ void SocketManager::run(Exception& exc) {
 
 
 #if defined(_WIN32)
-	MSG		  msg;
-    while(GetMessage(&msg,_eventSystem, 0, 0)) {
+	auto onMessage = [this](const MSG& msg) {
 		if(msg.wParam==0)
-			continue;
+			return;
 		if(msg.message==0) {
-			unique_ptr<Socket>* ppSocket = (unique_ptr<Socket>*)msg.wParam;
-			ppSocket->release(); // don't delete the pSocket!
-			delete ppSocket;
-			continue;
+			release((unique_ptr<Socket>*)msg.wParam);
+			return;
 		} else if (msg.message != 104) // unknown message
-			continue;
-		_currentEvent = WSAGETSELECTEVENT(msg.lParam);
-		_fakeSocket._sockfd = _sockfd = msg.wParam;
-		if(_currentEvent == FD_WRITE) {
-
-			// protected for _sockets access
+			return;
+		UInt32 event = WSAGETSELECTEVENT(msg.lParam);
+		NET_SOCKET sockfd = msg.wParam;
+		if(event == FD_WRITE) {
+
+			// a holder is released by this message loop (so not during this call), and protected for _ppSocket access as on linux
+			unique_ptr<Socket>* ppSocket(_manager._sockets.find(sockfd));
+			if (!ppSocket)
+				return;
 			lock_guard<mutex> lock(_mutex);
-			auto& it = _sockets.find(_sockfd);
-			if (it != _sockets.end()) {
-				Socket* pSocket = (*it->second).get();
+			Socket* pSocket(ppSocket->get());
+			if (pSocket) {
 				Exception curEx;
 				pSocket->flushSenders(curEx);
 				if (curEx)
 					pSocket->onError(curEx.error());
 			}
-
-		} else if (_currentEvent != FD_READ || _fakeSocket.available(_exSkip)) {
-			if (_currentEvent!=FD_CLOSE)
-				_currentError = WSAGETSELECTERROR(msg.lParam);
-			Task::waitHandle();
+			return;
 		}
+		_fakeSocket._sockfd = sockfd;
+		if (event != FD_READ || _fakeSocket.available(_exSkip))
+			dispatch(NULL, sockfd, event, event!=FD_CLOSE ? WSAGETSELECTERROR(msg.lParam) : 0);
+	};
 
-		_sockfd = INVALID_SOCKET;
+	MSG		  msg;
+	bool	  quit(false);
+    while(!quit && GetMessage(&msg,_eventSystem, 0, 0)) {
+		// take all the messages already queued to give them in one time to the handler
+		UInt32 count(0);
+		do {
+			if (msg.message == WM_QUIT) {
+				quit = true;
+				break;
+			}
+			onMessage(msg);
+			++count;
+		} while (PeekMessage(&msg, _eventSystem, 0, 0, PM_REMOVE));
+		flush(count);
 	}
 	DestroyWindow(_eventSystem);
 
@@ -333,6 +526,7 @@ void SocketManager::run(Exception& exc) {
 
     int count = _counter+1;
 	vector<epoll_event> events(count);
+	vector<unique_ptr<Socket>*> releasings;
 
 	for(;;) {
 
@@ -347,7 +541,7 @@ void SocketManager::run(Exception& exc) {
 		// for each ready socket
 		int i=0;
 		for(i;i<results;++i) {
-			epoll_event event = events[i];
+			epoll_event& event(events[i]);
 			if(event.data.fd==readFD) {
 				unique_ptr<Socket>* ppSocket(NULL);
                 read(readFD,&ppSocket,sizeof(ppSocket));
@@ -355,31 +549,37 @@ void SocketManager::run(Exception& exc) {
 					i=-1; // termination signal!
 					break;
 				}
-				ppSocket->release(); // don't delete the pSocket!
-				delete ppSocket;
+				// release it after this loop, some next events can concern it yet
+				releasings.emplace_back(ppSocket);
 				continue;		
 			}
-		
-			_currentEvent = event.events;
-			if(_currentEvent&EPOLLERR)
-                _currentError = Net::LastError();
-			if(_currentError==0 && _currentEvent&EPOLLOUT) {
-				// protected for _ppSocket access access
+
+			unique_ptr<Socket>* ppSocket((unique_ptr<Socket>*)event.data.ptr);
+			int error(event.events&EPOLLERR ? Net::LastError() : 0);
+			if(error==0 && event.events&EPOLLOUT) {
+				// protected for _ppSocket access
 				lock_guard<mutex> lock(_mutex);
-                _ppSocket = (unique_ptr<Socket>*)event.data.ptr;
-				if(_ppSocket->get()) {
+				Socket* pSocket(ppSocket->get());
+				if(pSocket) {
 					Exception curEx;
-					(*_ppSocket)->flush(curEx);
+					pSocket->flushSenders(curEx);
 					if (curEx)
-						(*_ppSocket)->onError(curEx.error());
+						pSocket->onError(curEx.error());
+					// rearm the oneshot socket if no read is pending (else it will be rearmed after the read)
+					if (!_selfHandler && !pSocket->_readsInReactor && !pSocket->_edgeTriggered && !(event.events&(EPOLLIN | EPOLLRDHUP | EPOLLHUP)) && !pSocket->_readPending && ppSocket->get())
+						_manager.update(_exSkip, *pSocket, pSocket->_writing);
 				}
-			} else {
-                _ppSocket = (unique_ptr<Socket>*)event.data.ptr;
-				Task::waitHandle();
 			}
-			_currentError = 0;
-			_ppSocket = NULL;
+			if(error || event.events&(EPOLLIN | EPOLLRDHUP | EPOLLHUP))
+				dispatch(ppSocket, NET_INVALID_SOCKET, event.events, error);
 		}
+
+		for (unique_ptr<Socket>* ppSocket : releasings)
+			release(ppSocket);
+		releasings.clear();
+		if (results>0)
+			flush(results);
+
 		if(i==-1)
 			break; // termination signal!
         count = _counter+1;
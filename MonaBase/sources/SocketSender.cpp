@@ -28,16 +28,20 @@ using namespace std;
 namespace Mona {
 
 SocketSender::SocketSender(const char* name) : WorkThread(name),
-	_position(0), _data(NULL), _size(0), _memcopied(false) {
+	_position(0), _data(NULL), _size(0), _queued(0) {
 }
 
 SocketSender::SocketSender(const char* name,const UInt8* data, UInt32 size) : WorkThread(name),
-	_position(0), _data((UInt8*)data), _size(size), _memcopied(false) {
+	_position(0), _data((UInt8*)data), _size(size), _queued(0) {
 }
 
-SocketSender::~SocketSender() {
-	if(_memcopied)
-		delete [] _data;
+SocketSender::SocketSender(const char* name,PoolBuffer& pBuffer) : WorkThread(name),
+	_position(0), _data(NULL), _size(0), _queued(0), _ppBuffer(new PoolBuffer(pBuffer.poolBuffers)) {
+	if (pBuffer.empty())
+		return;
+	_ppBuffer->swap(pBuffer);
+	_data = (*_ppBuffer)->data();
+	_size = (*_ppBuffer)->size();
 }
 
 bool SocketSender::run(Exception& ex) {
@@ -69,17 +73,21 @@ bool SocketSender::flush(Exception& ex,Socket& socket) {
 	// everything has been sent
 	if (_position == size())
 		return true;
-	// if data have been given on SocketSender construction we have to copy data to send it in an async way now
-	if (!_memcopied && _data == data()) {
-		_size = _size - _position;
-		UInt8* temp = new UInt8[_size](); // TODO replace by a pool buffer?
-		memcpy(temp, _data + _position, _size);
-		_data = temp;
-		_position = 0;
-		_memcopied = true;
-	}
 	// remains data to send
+	retain(socket.poolBuffers());
 	return false;
 }
 
+void SocketSender::retain(const PoolBuffers& poolBuffers) {
+	// if data have been given on SocketSender construction we have to copy data to send it in an async way now,
+	// excepting if they are already in a buffer owned by this sender
+	if (_ppBuffer || !_data || _data != data())
+		return;
+	_size = _size - _position;
+	_ppBuffer.reset(new PoolBuffer(poolBuffers, _size));
+	memcpy((*_ppBuffer)->data(), _data + _position, _size);
+	_data = (*_ppBuffer)->data();
+	_position = 0;
+}
+
 } // namespace Mona
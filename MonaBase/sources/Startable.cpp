@@ -25,12 +25,43 @@ This file is a part of Mona.
 #include <windows.h>
 #endif
 #include "Mona/Logs.h"
+#include <map>
 
 
 using namespace std;
 
 namespace Mona {
 
+// functions called by the threads which end
+struct ThreadEnds : virtual Object {
+	ThreadEnds() : released(false), nextId(0) {}
+	~ThreadEnds() { released = true; }
+	bool							released; // to ignore the functions in the static destructions which follow
+	UInt32							nextId;
+	std::mutex						mutex;
+	map<UInt32, function<void()>>	functions;
+};
+
+// built on the first call, to be usable by the static objects of the other units (and destroyed after them)
+static ThreadEnds& GetThreadEnds() {
+	static ThreadEnds Instance;
+	return Instance;
+}
+
+UInt32 Startable::AddThreadEnd(const function<void()>& function) {
+	ThreadEnds& threadEnds(GetThreadEnds());
+	lock_guard<mutex> lock(threadEnds.mutex);
+	threadEnds.functions[++threadEnds.nextId] = function;
+	return threadEnds.nextId;
+}
+
+void Startable::RemoveThreadEnd(UInt32 id) {
+	ThreadEnds& threadEnds(GetThreadEnds());
+	lock_guard<mutex> lock(threadEnds.mutex);
+	if (!threadEnds.released)
+		threadEnds.functions.erase(id);
+}
+
 
 Startable::Startable(const string& name) : _name(name), _stop(true) {
 	
@@ -79,6 +110,14 @@ void Startable::process() {
 	} catch (...) {
 		CRITIC("Startable thread ", _name, ", error unknown");
 	}
+	{
+		ThreadEnds& threadEnds(GetThreadEnds());
+		lock_guard<mutex> lock(threadEnds.mutex);
+		if (!threadEnds.released) {
+			for (auto& it : threadEnds.functions)
+				it.second();
+		}
+	}
 	lock_guard<mutex> lock(_mutexStop);
 	_stop = true;
 }
@@ -21,6 +21,8 @@ This file is a part of Mona.
 #include "Mona/TCPSender.h"
 #include "Mona/SocketManager.h"
 
+#define READ_MINIMUM	2048 // free space to read in the buffer, more is completed by the overflow of Socket::receive
+
 using namespace std;
 
 
@@ -59,53 +61,52 @@ const SocketAddress& TCPClient::peerAddress() {
 
 
 void TCPClient::onReadable(Exception& ex) {
-	UInt32 available = StreamSocket::available(ex);
-	if (ex)
-		return;
-	if(available==0) {
-		disconnect();
-		return;
+	// read until the socket is drained (without FIONREAD), a read which doesn't fill the free space means that nothing more is available,
+	// except in edge-triggered mode where the end of stream could be pending yet (its edge is consumed), so read then until EAGAIN
+	bool drained(false);
+	while (!drained && _connected) {
+		_pBuffer->resize(max(_pBuffer->capacity(), _rest + READ_MINIMUM), true);
+		UInt32 room(_pBuffer->size() - _rest);
+		int received = receive(ex, *_pBuffer, _rest);
+		if (received < 0) {
+			// nothing available (or error)
+			if (_rest == 0)
+				_pBuffer.release();
+			else
+				_pBuffer->resize(_rest, true);
+			return;
+		}
+		if (received == 0) {
+			disconnect(); // Graceful disconnection
+			return;
+		}
+		drained = !edgeTriggered() && (UInt32)received < room;
+		_rest += received;
+
+		while (_rest > 0) {
+
+			UInt16 port = address().port();
+
+			UInt32 rest = onReception(_pBuffer->data(),_rest);
+
+			if (rest > _rest)
+				rest = _rest;
+
+			// rest <= _rest, has consumed 0 or few bytes
+			if (rest > 0) {
+				if (_rest != rest) { // has consumed few bytes (but not all)
+					if (!_pBuffer.empty() && _pBuffer->size()>=_rest) // To prevent the case where the buffer has been manipulated during onReception call, if it happens, ignore copy!
+						memcpy(_pBuffer->data(), _pBuffer->data() + (_rest - rest), rest); // move to the beginning
+				}
+			} else // has consumed all
+				_pBuffer.release(); // release the buffer!
+
+			if (_rest == rest) // no new bytes consumption, wait next reception
+				break;
+
+			_rest = rest;
+		}
 	}
-
-	if(available>(_pBuffer->size() - _rest))
-		_pBuffer->resize(_rest+available,true);
-
-
-	int received = receiveBytes(ex,_pBuffer->data()+_rest, available);
-	if (ex)
-		return;
-
-	if (received <= 0) {
-		disconnect(); // Graceful disconnection
-		return;
-	}
-	_rest += received;
-	_pBuffer->resize(_rest,true);
-
-	while (_rest > 0) {
-
-		UInt16 port = address().port();
-
-		UInt32 rest = onReception(_pBuffer->data(),_rest);
-
-		if (rest > _rest)
-			rest = _rest;
-
-		// rest <= _rest, has consumed 0 or few bytes
-		if (rest > 0) {
-			if (_rest != rest) { // has consumed few bytes (but not all)
-				if (!_pBuffer.empty() && _pBuffer->size()>=_rest) // To prevent the case where the buffer has been manipulated during onReception call, if it happens, ignore copy!
-					memcpy(_pBuffer->data(), _pBuffer->data() + (_rest - rest), rest); // move to the beginning
-			}
-		} else // has consumed all
-			_pBuffer.release(); // release the buffer!
-
-		if (_rest == rest) // no new bytes consumption, wait next reception
-			break;
-
-		_rest = rest;
-	}
-
 }
 
 
@@ -134,4 +135,11 @@ bool TCPClient::send(Exception& ex,const UInt8* data,UInt32 size) {
 	return StreamSocket::send(ex, pSender);
 }
 
+bool TCPClient::send(Exception& ex,PoolBuffer& pBuffer) {
+	if(pBuffer.empty())
+		return true;
+	shared_ptr<TCPSender> pSender(new TCPSender("TCPClient::send",pBuffer));
+	return StreamSocket::send(ex, pSender);
+}
+
 } // namespace Mona
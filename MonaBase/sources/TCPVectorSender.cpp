@@ -0,0 +1,89 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+#include "Mona/TCPVectorSender.h"
+
+using namespace std;
+
+#define PARTS_BY_SEND	64
+
+namespace Mona {
+
+void TCPVectorSender::cut() {
+	UInt32 size(this->size());
+	if (!data() || size <= _cut)
+		return;
+	_parts.emplace_back((const UInt8*)NULL, _cut, size - _cut);
+	_cut = size;
+}
+
+UInt32 TCPVectorSender::pending() {
+	if (_parts.empty())
+		return SocketSender::pending();
+	UInt32 pending(data() && _cut < size() ? (size() - _cut) : 0);
+	for (UInt32 i = _part; i < _parts.size(); ++i)
+		pending += _parts[i].size;
+	return pending - _offset;
+}
+
+bool TCPVectorSender::flush(Exception& ex, Socket& socket) {
+	if (_parts.empty())
+		return SocketSender::flush(ex, socket); // nothing referenced, data() is sent in one block
+	cut(); // bytes written after the last reference
+
+	Socket::Part parts[PARTS_BY_SEND];
+	while (_part < _parts.size()) {
+		UInt32 count(0), total(0);
+		for (UInt32 i = _part; i < _parts.size() && count < PARTS_BY_SEND; ++i) {
+			const Part& part(_parts[i]);
+			Socket::Part& current(parts[count++]);
+			current.data = part.data ? part.data : (data() + part.offset);
+			current.size = part.size;
+			if (i == _part) {
+				current.data += _offset;
+				current.size -= _offset;
+			}
+			total += current.size;
+		}
+		int sent(((StreamSocket&)socket).sendBytes(ex, parts, count, NET_MSG_DONTWAIT));
+		if (ex) {
+			// terminate the sender
+			_part = _parts.size();
+			return true;
+		}
+		// skip what has been sent, until the middle of a part possibly
+		UInt32 rest(sent);
+		while (rest > 0) {
+			UInt32 available(_parts[_part].size - _offset);
+			if (rest < available) {
+				_offset += rest;
+				break;
+			}
+			rest -= available;
+			_offset = 0;
+			++_part;
+		}
+		if ((UInt32)sent < total)
+			return false; // socket buffer full, remains data to send
+	}
+	return true;
+}
+
+
+} // namespace Mona
@@ -33,4 +33,8 @@ void Task::waitHandle() {
 	_handler.waitHandle(*this);
 }
 
+void Task::postHandle(const shared_ptr<Task>& pThis) {
+	_handler.postHandle(pThis);
+}
+
 } // namespace Mona
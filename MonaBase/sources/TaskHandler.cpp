@@ -18,6 +18,7 @@ This file is a part of Mona.
 */
 
 #include "Mona/TaskHandler.h"
+#include "Mona/Logs.h"
 
 using namespace std;
 
@@ -27,6 +28,7 @@ namespace Mona {
 
 void TaskHandler::start() {
 	lock_guard<recursive_mutex> lock(_mutex);
+	_dropped = 0;
 	_stop=false;
 }
 
@@ -35,6 +37,10 @@ void TaskHandler::stop() {
 	lock_guard<recursive_mutex> lock(_mutex);
 	_stop=true;
 	_event.set();
+	// release the tasks which will never be handled
+	shared_ptr<Task> pTask;
+	while (_tasks.pop(pTask))
+		pTask.reset();
 }
 
 void TaskHandler::waitHandle(Task& task) {
@@ -49,8 +55,31 @@ void TaskHandler::waitHandle(Task& task) {
 	_event.wait();
 }
 
+void TaskHandler::postHandle(const shared_ptr<Task>& pTask) {
+	if (_stop) {
+		// the handler thread is gone, the task will never be handled (logged one time, then just counted)
+		if (!_dropped++)
+			WARN("Task posted to a stopped handler, dropped");
+		return;
+	}
+	_tasks.push(pTask);
+	// wake up the handler thread just if it has not been already requested
+	if (!_signaled.exchange(true))
+		requestHandle();
+}
+
 void TaskHandler::giveHandle(Exception& ex) {
 	lock_guard<recursive_mutex> lock(_mutex);
+	if (_signaled.exchange(false)) {
+		// drain all the posted tasks in one time
+		shared_ptr<Task> pTask;
+		while (!ex && _tasks.pop(pTask)) {
+			pTask->handle(ex);
+			pTask.reset();
+		}
+		if (ex) // tasks left will be handled on the next call
+			_signaled = true;
+	}
 	if(!_pTask)
 		return;
 	_pTask->handle(ex);
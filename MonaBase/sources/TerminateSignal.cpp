@@ -19,6 +19,7 @@ This file is a part of Mona.
 
 
 #include "Mona/TerminateSignal.h"
+#include "Mona/Memory.h"
 #if !defined(_WIN32)
     #include "signal.h"
 #else
@@ -58,12 +59,14 @@ TerminateSignal::TerminateSignal() {
 	sigaddset(&_signalSet, SIGINT);
 	sigaddset(&_signalSet, SIGQUIT);
 	sigaddset(&_signalSet, SIGTERM);
+	sigaddset(&_signalSet, SIGUSR2); // memory dump
 	sigprocmask(SIG_BLOCK, &_signalSet, NULL);
 }
 
 void TerminateSignal::wait() {
 	int signal;
-	sigwait(&_signalSet, &signal);
+	while (sigwait(&_signalSet, &signal) == 0 && signal == SIGUSR2)
+		Memory::Dump();
 }
 
 
@@ -0,0 +1,146 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+
+#include "Mona/Timers.h"
+#include <chrono>
+
+
+using namespace std;
+
+
+namespace Mona {
+
+void Timers::Timer::cancel() {
+	if (_pTimers)
+		_pTimers->remove(*this);
+}
+
+Timers::Timers() : _current(Now()), _count(0) {
+	memset(_slots, 0, sizeof(_slots));
+}
+
+Timers::~Timers() {
+	for (auto& level : _slots) {
+		for (Timer* pTimer : level) {
+			while (pTimer) {
+				pTimer->_pTimers = NULL;
+				pTimer = pTimer->_pNext;
+			}
+		}
+	}
+}
+
+Int64 Timers::Now() {
+	return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Timers::set(Timer& timer, Int64 now, UInt32 delay) {
+	if (timer._pTimers)
+		timer._pTimers->remove(timer);
+	timer._expiration = now + delay;
+	if (timer._expiration < _current)
+		timer._expiration = _current;
+	timer._pTimers = this;
+	++_count;
+	insert(timer);
+}
+
+void Timers::insert(Timer& timer) {
+	// level where the slot index changes no more before the expiration
+	Int64 delta(timer._expiration - _current);
+	UInt8 level(0);
+	while (level < (LEVELS - 1) && delta >= (Int64(1) << (BITS * (level + 1))))
+		++level;
+	Timer*& pHead(_slots[level][(timer._expiration >> (BITS * level)) & (SLOTS - 1)]);
+	timer._pPrev = NULL;
+	timer._pNext = pHead;
+	if (pHead)
+		pHead->_pPrev = &timer;
+	pHead = &timer;
+}
+
+void Timers::remove(Timer& timer) {
+	if (timer._pPrev)
+		timer._pPrev->_pNext = timer._pNext;
+	else {
+		// head of its slot
+		for (auto& level : _slots) {
+			Timer*& pHead(level[(timer._expiration >> (BITS * (&level - _slots))) & (SLOTS - 1)]);
+			if (pHead == &timer) {
+				pHead = timer._pNext;
+				break;
+			}
+		}
+	}
+	if (timer._pNext)
+		timer._pNext->_pPrev = timer._pPrev;
+	timer._pPrev = timer._pNext = NULL;
+	timer._pTimers = NULL;
+	--_count;
+}
+
+UInt32 Timers::raise(Int64 now) {
+	if (!_count) {
+		if (now >= _current)
+			_current = now + 1;
+		return 0;
+	}
+	while (_current <= now) {
+		UInt32 index(_current & (SLOTS - 1));
+		// cascade the slots of the upper levels which begin now
+		for (UInt8 level = 1; index == 0 && level < LEVELS; ++level) {
+			index = (_current >> (BITS * level)) & (SLOTS - 1);
+			Timer* pTimer(_slots[level][index]);
+			_slots[level][index] = NULL;
+			while (pTimer) {
+				Timer* pNext(pTimer->_pNext);
+				insert(*pTimer);
+				pTimer = pNext;
+			}
+		}
+		Timer*& pHead(_slots[0][_current & (SLOTS - 1)]);
+		while (pHead) {
+			Timer& timer(*pHead);
+			remove(timer);
+			UInt32 delay(timer.onTimer(now));
+			if (delay)
+				set(timer, now, delay);
+		}
+		++_current;
+		if (!_count) {
+			_current = now + 1;
+			return 0;
+		}
+	}
+	return next();
+}
+
+UInt32 Timers::next() const {
+	// first slot not empty of the first level, else the next cascade
+	UInt32 index(_current & (SLOTS - 1));
+	for (UInt32 delay = 0; delay < (SLOTS - index); ++delay) {
+		if (_slots[0][index + delay])
+			return delay + 1;
+	}
+	return SLOTS - index + 1;
+}
+
+
+} // namespace Mona
@@ -22,6 +22,8 @@ This file is a part of Mona.
 #include "Mona/UDPSender.h"
 #include "Mona/SocketManager.h"
 
+#define DATAGRAM_SIZE		2048 // bigger datagrams are completed by the overflow of Socket::receive
+#define DATAGRAMS_BY_READ	16
 
 using namespace std;
 
@@ -29,7 +31,7 @@ using namespace std;
 namespace Mona {
 
 
-UDPSocket::UDPSocket(const SocketManager& manager, bool allowBroadcast) : _pBuffer(manager.poolBuffers),_broadcasting(false), DatagramSocket(manager), _allowBroadcast(allowBroadcast) {
+UDPSocket::UDPSocket(const SocketManager& manager, bool allowBroadcast) : _pBuffer(manager.poolBuffers),_datagramSize(0),_broadcasting(false), DatagramSocket(manager), _allowBroadcast(allowBroadcast) {
 
 }
 
@@ -54,18 +56,109 @@ const SocketAddress& UDPSocket::peerAddress() {
 	return _peerAddress;
 }
 
+bool UDPSocket::setBatch(UInt16 count, UInt32 datagramSize) {
+	if (!DatagramSocket::setBatch(count))
+		return false;
+	count = DatagramSocket::batch();
+	if (!count && gro())
+		DatagramSocket::setGRO(false);
+	_datagramSize = datagramSize;
+	_buffers.clear();
+	while (_buffers.size() < count)
+		_buffers.emplace_back(manager.poolBuffers, datagramSize);
+	_pBuffers.resize(count);
+	_addresses.resize(count);
+	_segments.resize(count);
+	return true;
+}
+
+bool UDPSocket::setGRO(bool enable) {
+	if (enable && !batch())
+		return false; // coalesced datagrams are split only by the batch reception
+	return DatagramSocket::setGRO(enable);
+}
+
 void UDPSocket::onReadable(Exception& ex) {
-	UInt32 available = DatagramSocket::available(ex);
-	if(ex || available==0)
-		return;
-
-	_pBuffer->resize(available, false);
-	int size = receiveFrom(ex,_pBuffer->data(), available, _addressFrom);
-	if (!ex) {
-		_pBuffer->resize(size, true);
-		onReception(_pBuffer->data(),size,_addressFrom);
+	// Only EAGAIN drains the socket: an error (ECONNREFUSED of an ICMP port unreachable...) concerns one datagram sent before,
+	// it's reported and the reading goes on, unless it repeats immediately (broken socket) where it's given to the caller
+	bool failed(false);
+	if (!_buffers.empty()) {
+		// edge-triggered, read until a reception doesn't fill all the buffers
+		for (;;) {
+			Exception exRead;
+			bool full(receiveBatch(exRead));
+			if (exRead) {
+				if (!full && failed) {
+					ex.set(exRead);
+					return;
+				}
+				onError(exRead.error());
+				failed = !full;
+			} else if (!full)
+				return; // drained
+			else
+				failed = false;
+			if (!edgeTriggered() && !failed)
+				return;
+		}
+	}
+
+	// read datagrams until the socket is drained (without FIONREAD), by a maximum of DATAGRAMS_BY_READ to let others sockets be read
+	// (except in edge-triggered mode which requires to read until EAGAIN)
+	for (UInt32 i = 0; i < DATAGRAMS_BY_READ || edgeTriggered(); ++i) {
+		if (_pBuffer->capacity() < DATAGRAM_SIZE)
+			_pBuffer->resize(DATAGRAM_SIZE, false);
+		else
+			_pBuffer->resize(_pBuffer->capacity(), false);
+		Exception exRead;
+		int size = receive(exRead, *_pBuffer, 0, _addressFrom);
+		if (size < 0) {
+			if (!exRead)
+				break; // nothing available
+			if (failed) {
+				ex.set(exRead);
+				break;
+			}
+			onError(exRead.error());
+			failed = true;
+			continue;
+		}
+		failed = false;
+		if (size > 0) // ignore empty datagram
+			onReception(_pBuffer->data(), size, _addressFrom);
+		_pBuffer.release();
+	}
+	_pBuffer.release();
+}
+
+bool UDPSocket::receiveBatch(Exception& ex) {
+	for (UInt32 i = 0; i < _buffers.size(); ++i) {
+		_pBuffers[i] = &*_buffers[i];
+		_pBuffers[i]->resize(gro() ? 0xFFFF : _datagramSize, false);
+	}
+	int count = DatagramSocket::receiveFrom(ex, _pBuffers.data(), _addresses.data(), _pBuffers.size(), gro() ? _segments.data() : NULL);
+	for (int i = 0; i < count; ++i) {
+		UInt32 size(_pBuffers[i]->size());
+		if (size == 0)
+			continue; // empty or truncated
+		if (gro() && _segments[i] && _segments[i] < size) {
+			// coalesced by GRO, copy each datagram in the raw buffer to keep the unbatched behavior
+			const UInt8* data(_pBuffers[i]->data());
+			for (UInt32 position = 0; position < size; position += _segments[i]) {
+				UInt32 length(min<UInt32>(_segments[i], size - position));
+				_pBuffer->resize(length, false);
+				memcpy(_pBuffer->data(), data + position, length);
+				onReception(_pBuffer->data(), length, _addresses[i]);
+				_pBuffer.release();
+			}
+			continue;
+		}
+		// the datagram becomes the raw buffer during onReception, exactly as in the unbatched mode
+		_pBuffer.swap(_buffers[i]);
+		onReception(_pBuffer->data(), _pBuffer->size(), _addresses[i]);
 		_pBuffer.release();
 	}
+	return count == (int)_pBuffers.size();
 }
 
 void UDPSocket::close() {
@@ -58,6 +58,7 @@ public:
 	static AMFWriter    Null;
 
 private:
+	friend class RTMFPMessageBuffered;
 	AMFWriter() : _amf3(false), amf0Preference(false) {} // null version
 
 	void writeInteger(Int32 value);
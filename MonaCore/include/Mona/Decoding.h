@@ -22,6 +22,7 @@ This file is a part of Mona.
 #include "Mona/Mona.h"
 #include "Mona/Invoker.h"
 #include "Mona/PoolBuffer.h"
+#include <vector>
 
 
 namespace Mona {
@@ -35,21 +36,31 @@ public:
 	Decoding(const char* name,Invoker& invoker,const UInt8* data,UInt32 size);
 	Decoding(const char* name,Invoker& invoker,PoolBuffer& pBuffer);
 
+protected:
+	// Called in the main thread to pass each decoded piece to the session
+	virtual void			receive(Session& session, const UInt8* data, UInt32 size);
+
 private:
 	// If return true, packet is pass to the session.
 	// If ex is raised on true returned value, it displays a WARN
 	// If ex is raised on false returned value, it displays a ERROR
 	virtual const UInt8*	decodeRaw(Exception& ex, PoolBuffer& pBuffer, UInt32 times,const UInt8* data,UInt32& size);
 	virtual bool			decode(Exception& ex, PacketReader& packet, UInt32 times) { return false; }
+	// Return false if decodeRaw can invalidate the previous decoded pieces,
+	// then each piece is handled by the main thread before to decode the next one.
+	// Otherwise all the pieces are posted in one time to the main thread, without waiting
+	virtual bool			stablePieces() { return true; }
 
 	bool			run(Exception& ex);
 	void			handle(Exception& ex);
 
 	PoolBuffer						_pBuffer;
 	Expirable<Session>				_expirableSession;
+	std::weak_ptr<Decoding>			_pThis;
 	SocketAddress					_address;
 	UInt32							_size;
 	const UInt8*					_current;
+	std::vector<std::pair<const UInt8*,UInt32>>	_pieces;
 };
 
 
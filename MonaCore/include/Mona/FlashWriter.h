@@ -38,6 +38,7 @@ public:
 	AMFWriter&				writeAMFStatus(const std::string& code, const std::string& description, bool withoutClosing = false) { return writeAMFState("onStatus", code, description, withoutClosing); }
 	AMFWriter&				writeAMFError(const std::string& code, const std::string& description, bool withoutClosing = false) { return writeAMFState("_error", code, description, withoutClosing); }
 	bool					writeMedia(MediaType type,UInt32 time,PacketReader& packet);
+	bool					writeMedia(MediaType type,UInt32 time,const std::shared_ptr<MediaFrame>& pFrame);
 
 protected:
 	FlashWriter(WriterHandler* pHandler=NULL);
@@ -45,6 +46,8 @@ protected:
 	virtual ~FlashWriter();
 
 	virtual AMFWriter&		write(AMF::ContentType type,UInt32 time=0,PacketReader* pPacket=NULL)=0;
+	// to overload to reference the frame rather than copying it
+	virtual void			write(AMF::ContentType type,UInt32 time,const std::shared_ptr<MediaFrame>& pFrame);
 
 	AMFWriter&				writeAMFState(const std::string& name,const std::string& code,const std::string& description,bool withoutClosing=false);
 };
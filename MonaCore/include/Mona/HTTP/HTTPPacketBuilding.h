@@ -32,6 +32,8 @@ public:
 	const std::shared_ptr<HTTPPacket> pPacket;
 private:
 	const UInt8* decodeRaw(Exception& ex, PoolBuffer& pBuffer, UInt32 times,const UInt8* data,UInt32& size) { return pPacket->build(ex,pBuffer,data,size); }
+	// build swaps the buffers, so a piece is no more valid after the next build
+	bool		 stablePieces() { return false; }
 
 	const std::shared_ptr<PoolBuffer>	 _ppBuffer;
 };
@@ -21,7 +21,7 @@ This file is a part of Mona.
 
 #include "Mona/Mona.h"
 #include "Mona/Writer.h"
-#include "Mona/TCPSender.h"
+#include "Mona/TCPVectorSender.h"
 #include "Mona/FilePath.h"
 #include "Mona/HTTP/HTTP.h"
 #include "Mona/HTTP/HTTPPacket.h"
@@ -43,7 +43,7 @@ namespace Mona {
 #define HTTP_END_HEADER(BINARYWRITER)  BINARYWRITER.writeRaw("\r\n");
 
 
-class HTTPSender : public TCPSender, virtual Object {
+class HTTPSender : public TCPVectorSender, virtual Object {
 public:
 	HTTPSender(const SocketAddress& address,const std::shared_ptr<HTTPPacket>& pRequest);
 
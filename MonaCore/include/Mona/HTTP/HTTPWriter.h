@@ -47,6 +47,7 @@ public:
 	Time							timeout;
 
 	State			state(State value=GET,bool minimal=false);
+	bool			congested() { return _tcpClient.socket().congested(); }
 	void			flush(bool full=false);
 
 	DataWriter&		writeInvocation(const std::string& type) { return write("200  OK", HTTP::ParseContentType(type.c_str(), _buffer), _buffer);}
@@ -62,6 +63,7 @@ public:
 	MediaContainer::Type	mediaType;
 private:
 	bool			writeMedia(MediaType type,UInt32 time,PacketReader& packet);
+	bool			writeMedia(MediaType type,UInt32 time,const std::shared_ptr<MediaFrame>& pFrame);
 	
 	HTTPSender& createSender() {
 		_senders.emplace_back(new HTTPSender(_tcpClient.address(),pRequest));
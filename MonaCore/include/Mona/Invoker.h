@@ -28,6 +28,7 @@ This file is a part of Mona.
 #include "Mona/TaskHandler.h"
 #include "Mona/PoolThreads.h"
 #include "Mona/PoolBuffers.h"
+#include "Mona/Timers.h"
 #include "Mona/ServerParams.h"
 #include "Mona/FlashMainStream.h"
 #include "Mona/RelayServer.h"
@@ -45,6 +46,7 @@ public:
 	const RelayServer		relay;
 	PoolThreads				poolThreads;
 	const PoolBuffers		poolBuffers;
+	Timers					timers; // raised by the main server thread, to use only from it
 
 	std::shared_ptr<FlashStream>&	createFlashStream(Peer& peer);
 	FlashStream&					flashStream(UInt32 id, Peer& peer,std::shared_ptr<FlashStream>& pStream);
@@ -58,17 +60,18 @@ public:
 	Listener*				subscribe(Exception& ex,Peer& peer,const std::string& name,Writer& writer,double start=-2000);
 	void					unsubscribe(Peer& peer,const std::string& name);
 
-	void					addBanned(const IPAddress& ip) { _bannedList.insert(ip); }
-	void					removeBanned(const IPAddress& ip) { _bannedList.erase(ip); }
-	void					clearBannedList() { _bannedList.clear(); }
-	bool					isBanned(const IPAddress& ip) { return _bannedList.find(ip) != _bannedList.end(); }
+	// thread-safe, isBanned can be called by the socket reactors
+	void					addBanned(const IPAddress& ip) { std::lock_guard<std::mutex> lock(_mutexBanned); _bannedList.insert(ip); }
+	void					removeBanned(const IPAddress& ip) { std::lock_guard<std::mutex> lock(_mutexBanned); _bannedList.erase(ip); }
+	void					clearBannedList() { std::lock_guard<std::mutex> lock(_mutexBanned); _bannedList.clear(); }
+	bool					isBanned(const IPAddress& ip) { std::lock_guard<std::mutex> lock(_mutexBanned); return _bannedList.find(ip) != _bannedList.end(); }
 
 	const ServerParams		params;
 
 	std::string				buffer;
 
 protected:
-	Invoker(UInt32 socketBufferSize,UInt16 threads);
+	Invoker(UInt32 socketBufferSize,UInt16 threads,UInt16 reactors=1);
 	virtual ~Invoker();
 
 private:
@@ -76,6 +79,7 @@ private:
 
 	std::map<std::string,Publication>				_publications;
 	std::set<IPAddress>								_bannedList;
+	std::mutex										_mutexBanned;
 	UInt32											_nextId;
 	std::map<UInt32,std::shared_ptr<FlashStream> >	_streams;
 };
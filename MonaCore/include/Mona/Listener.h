@@ -23,6 +23,7 @@ This file is a part of Mona.
 #include "Mona/Writer.h"
 #include "Mona/QualityOfService.h"
 #include "Mona/Client.h"
+#include "Mona/MediaFrame.h"
 
 namespace Mona {
 
@@ -35,8 +36,8 @@ public:
 	void startPublishing();
 	void stopPublishing(); 
 
-	void pushAudioPacket(PacketReader& packet,UInt32 time=0); 
-	void pushVideoPacket(PacketReader& packet,UInt32 time=0);
+	void pushAudioPacket(const std::shared_ptr<MediaFrame>& pFrame,UInt32 time=0); 
+	void pushVideoPacket(const std::shared_ptr<MediaFrame>& pFrame,UInt32 time=0);
 	void pushDataPacket(DataReader& reader);
 
 	void flush();
@@ -61,6 +62,10 @@ private:
 	UInt32 	computeTime(UInt32 time);
 	PacketReader& publicationNamePacket() { _publicationNamePacket.reset(); return _publicationNamePacket; }
 
+	// the writer of this subscriber can't follow, its non-key video frames are dropped until it's drained
+	void	onWriteBlocked();
+	void	onWriteDrained();
+
 	/// WriterHandler implementation
 	void	close(Writer& writer, int code);
 
@@ -69,6 +74,7 @@ private:
 	bool					_firstAudio;
 	bool					_firstVideo;
 	bool					_firstTime;
+	bool					_congested;
 
 	UInt32 					_deltaTime;
 	UInt32 					_addingTime;
@@ -63,6 +63,9 @@ public:
 		static void Write(BinaryWriter& writer,UInt8 track=BOTH);
 		// To write audio or video packet
 		static void Write(BinaryWriter& writer, UInt8 track, UInt32 time, const UInt8* data, UInt32 size);
+		// To write audio or video packet without its payload, which has to be sent between the tag header and the tag footer
+		static void WriteTagHeader(BinaryWriter& writer, UInt8 track, UInt32 time, UInt32 size);
+		static void WriteTagFooter(BinaryWriter& writer, UInt32 size) { writer.write32(11+size); }
 	};
 
 	class MPEGTS : virtual Static {
@@ -0,0 +1,47 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+#pragma once
+
+#include "Mona/Mona.h"
+#include "Mona/PoolBuffer.h"
+
+namespace Mona {
+
+/// Immutable audio or video frame, created once by a Publication and shared by all its listeners,
+/// writers can so keep a reference on it (in a message or a sender) rather than copying its payload
+class MediaFrame : virtual Object {
+public:
+	MediaFrame(const PoolBuffers& poolBuffers, const UInt8* data, UInt32 size) : _pBuffer(poolBuffers, size), _size(size) {
+		_data = _pBuffer->data();
+		if (size > 0)
+			memcpy((UInt8*)_data, data, size);
+	}
+
+	const UInt8*	data() const { return _data; }
+	UInt32			size() const { return _size; }
+
+private:
+	PoolBuffer		_pBuffer;
+	const UInt8*	_data;
+	const UInt32	_size;
+};
+
+
+} // namespace Mona
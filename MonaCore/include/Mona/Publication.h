@@ -23,12 +23,13 @@ This file is a part of Mona.
 #include "Mona/Exceptions.h"
 #include "Mona/Listeners.h"
 #include "Mona/Peer.h"
+#include "Mona/MediaFrame.h"
 
 namespace Mona {
 
 class Publication : virtual Object {
 public:
-	Publication(const std::string& name);
+	Publication(const std::string& name,const PoolBuffers& poolBuffers);
 	virtual ~Publication();
 
 	const std::string&		name() const { return _name; }
@@ -60,6 +61,7 @@ public:
 	const Buffer&			audioCodecBuffer() const { return _audioCodecBuffer; }
 	const Buffer&			videoCodecBuffer() const { return _videoCodecBuffer; }
 private:
+	const PoolBuffers&					_poolBuffers;
 	Peer*								_pPublisher;
 	bool								_firstKeyFrame;
 	std::string							_name;
@@ -21,6 +21,8 @@ This file is a part of Mona.
 
 #include "Mona/Mona.h"
 #include "Mona/PacketWriter.h"
+#include "Mona/Timers.h"
+#include "Mona/RTMFP/RTMFPCongestion.h"
 
 namespace Mona {
 
@@ -31,6 +33,13 @@ public:
 	virtual void							initWriter(const std::shared_ptr<RTMFPWriter>& pWriter)=0;
 	virtual std::shared_ptr<RTMFPWriter>	changeWriter(RTMFPWriter& writer) = 0;
 	virtual void							close()=0;
+	virtual Timers&							timers()=0;
+	// round-trip time in ms, 0 if unknown
+	virtual UInt16							ping()=0;
+	// congestion control shared by the writers of the band
+	virtual RTMFPCongestion&				congestion()=0;
+	// writer will be managed soon by the band (to flush its messages when the congestion allows it, or to release it once closed)
+	virtual void							manageWriter(RTMFPWriter& writer)=0;
 
 	virtual bool						failed() const = 0;
 	virtual bool						canWriteFollowing(RTMFPWriter& writer)=0;
@@ -25,6 +25,7 @@ This file is a part of Mona.
 #include "Mona/Time.h"
 #include <openssl/evp.h>
 #include <math.h>
+#include <mutex>
 
 namespace Mona {
 
@@ -38,12 +39,21 @@ namespace Mona {
 
 
 class RTMFPKey : virtual Object {
+	friend class RTMFPEngine;
 public:
-	RTMFPKey(const UInt8* key) {memcpy(_key, key, RTMFP_KEY_SIZE);}
+	RTMFPKey(const UInt8* key);
+	virtual ~RTMFPKey();
+
 	const UInt8* value() { return _key; }
 
 private:
-	UInt8 _key[RTMFP_KEY_SIZE];	
+	// context keyed on the first use of a direction (key schedule expanded one time),
+	// a key is used by one thread at a time (decodings and sendings of a session are serialized on their PoolThread)
+	EVP_CIPHER_CTX&	context(UInt8 direction);
+
+	UInt8			_key[RTMFP_KEY_SIZE];
+	EVP_CIPHER_CTX	_contexts[2];
+	bool			_keyed[2];
 };
 
 class RTMFPEngine : virtual NullableObject {
@@ -56,8 +66,8 @@ public:
 		NORMAL=0,
 		DEFAULT
 	};
-	RTMFPEngine(const std::shared_ptr<RTMFPKey>& pKey,Direction direction);
-	virtual ~RTMFPEngine();
+
+	RTMFPEngine(const std::shared_ptr<RTMFPKey>& pKey,Direction direction) : type(NORMAL),_direction(direction),_pKey(pKey) {}
 
 	void		  process(const UInt8* in,UInt8* out,int size);
 
@@ -65,11 +75,9 @@ public:
 private:
 	Direction						_direction;
 	const std::shared_ptr<RTMFPKey> _pKey;
-	EVP_CIPHER_CTX					_context;
 
 	static const std::shared_ptr<RTMFPKey>	_pDefaultKey;
-	static RTMFPEngine						_DefaultDecrypt;
-	static RTMFPEngine						_DefaultEncrypt;
+	static std::mutex						_DefaultMutex; // default key is shared by all the threads
 };
 
 
@@ -90,11 +98,11 @@ public:
 														 UInt8* requestKey,
 														 UInt8* responseKey);
 
+	// one's complement sum of the big-endian 16-bit words of data (a last odd byte is added as is), vectorized with SSE2/AVX2 when available
+	static UInt16				CheckSum(const UInt8* data, UInt32 size);
+
 	static UInt16				TimeNow() { return Time(Mona::Time()); }
 	static UInt16				Time(Int64 timeVal) { return (UInt32)round(timeVal / (1000.0*RTMFP_TIMESTAMP_SCALE)); }
-
-private:
-	static UInt16				CheckSum(PacketReader& packet);
 };
 
 }  // namespace Mona
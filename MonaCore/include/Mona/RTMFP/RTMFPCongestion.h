@@ -0,0 +1,73 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+#pragma once
+
+#include "Mona/Mona.h"
+
+namespace Mona {
+
+/// Congestion control of a RTMFP session, shared by all its writers.
+/// Window in bytes in flight which grows like CUBIC (slow start, then cubic function of the time since the last loss),
+/// and pacing which spreads the sendings of one window over one round-trip time rather than to send it in one burst.
+/// All the times are in ms (see Timers::Now)
+class RTMFPCongestion : virtual Object {
+public:
+	// initial window in bytes, 0 for the default one (10 packets)
+	RTMFPCongestion(UInt32 initialWindow = 0) : _initialWindow(initialWindow) { reset(); }
+
+	// congestion window, in bytes
+	UInt32	window() const { return (UInt32)_window; }
+	// bytes sent and not yet acknowledged
+	UInt32	inFlight() const { return _inFlight; }
+	// pacing rate, in bytes/s
+	double	rate() const;
+
+	// delay in ms to wait before to send new data (window full or pacing), 0 if it can be sent now
+	UInt32	delay(Int64 now);
+
+	// repeated bytes are paced but are not counted in flight (already counted on the first sending)
+	void	sent(Int64 now, UInt32 size, bool repeated = false);
+	// rtt in ms, 0 if unknown
+	void	acknowledged(Int64 now, UInt32 size, UInt16 rtt);
+	// loss detected (negative acknowledgment or repetition timeout), the window decreases at most one time by round-trip
+	void	lost(Int64 now);
+	// bytes which will never be acknowledged (message abandoned, writer cleared)
+	void	released(UInt32 size) { _inFlight = size < _inFlight ? (_inFlight - size) : 0; }
+
+	void	reset();
+
+private:
+	const UInt32	_initialWindow;
+
+	double	_window;
+	double	_threshold; // slow start threshold
+	double	_windowMax; // window before the last decrease
+	double	_windowTCP; // window which would have a standard TCP, CUBIC is never less aggressive than it
+	double	_k; // time in s to come back to _windowMax
+	Int64	_epoch; // beginning of the current congestion avoidance period, 0 if it has not begun
+	Int64	_lastLoss;
+	Int64	_lastAck; // last acknowledgment, or first sending after an empty flight
+	UInt32	_inFlight;
+	UInt16	_rtt;
+	double	_nextSending; // pacing, time of the next sending
+};
+
+
+} // namespace Mona
@@ -21,6 +21,7 @@ This file is a part of Mona.
 
 #include "Mona/Mona.h"
 #include "Mona/Invoker.h"
+#include "Mona/UDPSocket.h"
 #include "Mona/RTMFP/RTMFPCookieComputing.h"
 
 
@@ -35,6 +36,8 @@ public:
 	const std::string		tag;
 
 	const std::shared_ptr<Peer> pPeer;
+	// shard which has received the handshake, the session will be bound to it
+	UDPSocket*				pSocket;
 
 	bool					run(Exception& ex) { _pComputingThread = _invoker.poolThreads.enqueue<RTMFPCookieComputing>(ex, _pCookieComputing, _pComputingThread); return !ex; }
 
@@ -21,20 +21,24 @@ This file is a part of Mona.
 
 #include "Mona/Mona.h"
 #include "Mona/Decoding.h"
+#include "Mona/RTMFP/RTMFPSession.h"
 
 namespace Mona {
 
 
 class RTMFPDecoding : public Decoding, virtual Object {
 public:
-	RTMFPDecoding(Invoker& invoker,PoolBuffer& pBuffer,const std::shared_ptr<RTMFPKey>& pDecryptKey,RTMFPEngine::Type type) : Decoding("RTMFPDecoding",invoker,pBuffer),_decoder(pDecryptKey,RTMFPEngine::DECRYPT) {
+	// socket is the shard which has received the packet
+	RTMFPDecoding(Invoker& invoker,UDPSocket& socket,PoolBuffer& pBuffer,const std::shared_ptr<RTMFPKey>& pDecryptKey,RTMFPEngine::Type type) : Decoding("RTMFPDecoding",invoker,pBuffer),_decoder(pDecryptKey,RTMFPEngine::DECRYPT),_socket(socket) {
 		_decoder.type = type;
 	}
 
 private:
+	void		  receive(Session& session, const UInt8* data, UInt32 size) { ((RTMFPSession&)session).receiving(_socket); Decoding::receive(session, data, size); }
 	bool		  decode(Exception& ex, PacketReader& packet, UInt32 times) { if (times) return false;  packet.next(4); return RTMFP::Decode(ex, _decoder, packet); }
 
 	RTMFPEngine	  _decoder;
+	UDPSocket&	  _socket;
 };
 
 
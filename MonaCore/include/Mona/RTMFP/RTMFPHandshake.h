@@ -51,6 +51,8 @@ private:
 	void		flush() { RTMFPSession::flush(0x0b, false); (UInt32&)farId=0; }
 
 	void		packetHandler(PacketReader& packet);
+	// the handshake answers always by the protocol socket, but binds the sessions created on the shard of their cookie
+	void		receiving(UDPSocket& socket) { _pReceiver = &socket; }
 	UInt8		handshakeHandler(UInt8 id,PacketReader& request,PacketWriter& response);
 
 	struct CompareCookies {
@@ -62,6 +64,7 @@ private:
 	std::map<const UInt8*,RTMFPCookie*,CompareCookies>  _cookies; // RTMFPCookie, in waiting of creation session
 	UInt8												_certificat[77];
 	Sessions&											_sessions;
+	UDPSocket*											_pReceiver;
 	std::shared_ptr<Peer>								_pPeer;
 };
 
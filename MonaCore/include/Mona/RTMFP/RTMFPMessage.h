@@ -21,6 +21,8 @@ This file is a part of Mona.
 
 #include "Mona/Mona.h"
 #include "Mona/AMFWriter.h"
+#include "Mona/AMF.h"
+#include "Mona/MediaFrame.h"
 
 
 namespace Mona {
@@ -29,48 +31,119 @@ namespace Mona {
 class RTMFPMessage : virtual Object {
 public:
 
-	RTMFPMessage(bool repeatable) : repeatable(repeatable) {}
+	RTMFPMessage(bool repeatable) : repeatable(repeatable), fragments(0) {}
+
+	// messages are allocated in a slab shared by all the writers
+	static void*	operator new(std::size_t size);
+	static void		operator delete(void* pMessage, std::size_t size);
 
-	virtual const UInt8*	data()=0;
 	virtual UInt32			size()=0;
+	// write the fragment [offset, offset+size[ of the message
+	virtual void			write(BinaryWriter& writer,UInt32 offset,UInt32 size)=0;
 
-	std::map<UInt32,UInt64>	fragments;
+	UInt32					fragments; // fragments sent and not yet acknowledged (see RTMFPFragments)
 	const bool				repeatable;
 
 	Time					sendingTime;
 };
 
 
+/// Fragments sent and not yet acknowledged of a writer, indexed directly by their stage in a ring (capacity power of 2).
+/// Stages are contiguous, pushed on the first sending and popped from the front,
+/// so an acknowledgment reaches its lost stages without walking the ones received
+class RTMFPFragments : virtual Object {
+public:
+	struct Fragment {
+		RTMFPMessage*	pMessage;
+		UInt32			offset; // in the message
+		UInt32			size;
+		UInt64			stage; // stage of the last sending, a repetition waits that the receiver gets it
+	};
+
+	RTMFPFragments() : _fragments(NULL), _mask(0), _front(0), _back(0) {}
+	virtual ~RTMFPFragments() { delete [] _fragments; }
+
+	bool		empty() const { return _front == _back; }
+	UInt32		size() const { return UInt32(_back - _front); }
+	// first stage not acknowledged, and stage following the last one sent
+	UInt64		front() const { return _front; }
+	UInt64		back() const { return _back; }
+
+	// stage must be in [front, back[
+	Fragment&	operator[](UInt64 stage) { return _fragments[stage & _mask]; }
+
+	// stage must follow the last one pushed (or starts the ring if empty)
+	void		push(UInt64 stage, RTMFPMessage& message, UInt32 offset, UInt32 size);
+	// returned fragment stays valid until the next push
+	Fragment&	pop() { return _fragments[_front++ & _mask]; }
+
+private:
+	Fragment*	_fragments;
+	UInt64		_mask;
+	UInt64		_front;
+	UInt64		_back;
+};
+
+
 class RTMFPMessageUnbuffered : public RTMFPMessage, virtual Object {
 public:
-	RTMFPMessageUnbuffered(const UInt8* data, UInt32 size) : _data(data), _size(size),RTMFPMessage(false) {}
+	RTMFPMessageUnbuffered(const PoolBuffers& poolBuffers,const UInt8* data, UInt32 size) : _data(data), _size(size),_buffer(poolBuffers,size),RTMFPMessage(false) {}
+
+	// copies the data referenced, to call when the message stays queued after the write call (data are valid just during this call)
+	void			retain();
 	
 private:
-	const UInt8*	data() { return _data; }
 	UInt32			size() { return _size; }
+	void			write(BinaryWriter& writer,UInt32 offset,UInt32 size) { writer.writeRaw(_data+offset,size); }
 
 	UInt32			_size;
 	const UInt8*	_data;
+	PoolBuffer		_buffer; // empty while the data are not retained
 };
 
 
 
 class RTMFPMessageBuffered: public RTMFPMessage, virtual NullableObject {
 public:
-	RTMFPMessageBuffered(const PoolBuffers& poolBuffers,bool repeatable) : _pWriter(new AMFWriter(poolBuffers)),RTMFPMessage(repeatable) {}
-	RTMFPMessageBuffered() : _pWriter(&AMFWriter::Null),RTMFPMessage(false),NullableObject(true) {}
-	
-	virtual ~RTMFPMessageBuffered() { if (_pWriter != &AMFWriter::Null) delete _pWriter; }
+	RTMFPMessageBuffered(const PoolBuffers& poolBuffers,bool repeatable) : _writer(poolBuffers),RTMFPMessage(repeatable) {}
+	RTMFPMessageBuffered() : RTMFPMessage(false),NullableObject(true) {}
 
-	AMFWriter&		writer() { return *_pWriter; }
+	AMFWriter&		writer() { return _writer; }
 
 private:
 
-	const UInt8*	data() { return _pWriter->packet.data(); }
-	UInt32			size() { return _pWriter->packet.size(); }
+	UInt32			size() { return _writer.packet.size(); }
+	void			write(BinaryWriter& writer,UInt32 offset,UInt32 size) { writer.writeRaw(_writer.packet.data()+offset,size); }
+
+	AMFWriter		_writer; // null for the null message
+
+};
 
-	AMFWriter*		_pWriter;
 
+/// Audio or video message, just its header is owned, the payload is the frame shared by all the listeners of the publication
+class RTMFPMessageMedia : public RTMFPMessage, virtual Object {
+public:
+	RTMFPMessageMedia(AMF::ContentType type,UInt32 time,const std::shared_ptr<MediaFrame>& pFrame,bool repeatable) : _pFrame(pFrame),RTMFPMessage(repeatable) {
+		BinaryWriter(_header,sizeof(_header)).write8(type).write32(time);
+	}
+
+private:
+	UInt32			size() { return sizeof(_header)+_pFrame->size(); }
+	void			write(BinaryWriter& writer,UInt32 offset,UInt32 size) {
+		if (offset < sizeof(_header)) {
+			UInt32 count(sizeof(_header)-offset);
+			if (count > size)
+				count = size;
+			writer.writeRaw(_header+offset,count);
+			offset += count;
+			size -= count;
+		}
+		if (size>0)
+			writer.writeRaw(_pFrame->data()+offset-sizeof(_header),size);
+	}
+
+	UInt8							_header[5]; // type + time
+	const std::shared_ptr<MediaFrame>	_pFrame;
 };
 
 
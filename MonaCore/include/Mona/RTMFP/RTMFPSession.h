@@ -27,14 +27,18 @@ This file is a part of Mona.
 #include "Mona/RTMFP/RTMFPSender.h"
 #include "Mona/RTMFP/RTMFPCookieComputing.h"
 #include "Mona/Time.h"
+#include <mutex>
 
 namespace Mona {
 
 class RTMFProtocol;
-class RTMFPSession : public BandWriter,public Session, virtual Object {
+class RTMFPSession : public BandWriter,public Session, private Timers::Timer, virtual Object {
+	friend class RTMFPDecoding;
 public:
 
+	// socket is the shard which has received the handshake, the session is bound to it
 	RTMFPSession(RTMFProtocol& protocol,
+			UDPSocket& socket,
 			Invoker& invoker,
 			UInt32 farId,
 			const UInt8* decryptKey,
@@ -47,7 +51,8 @@ public:
 
 	std::shared_ptr<RTMFPCookieComputing>	pRTMFPCookieComputing;
 
-	void				decode(PoolBuffer& poolBuffer, const SocketAddress& address);
+	// socket is the shard which has received the packet, can be called by its reactor thread
+	void				decode(UDPSocket& socket, PoolBuffer& poolBuffer, const SocketAddress& address);
 
 	bool				failed() const { return _failed; }
 
@@ -61,6 +66,8 @@ protected:
 
 	const UInt32		farId;
 	PacketWriter&		packet();
+	// main thread, before the handling of a packet received by socket
+	virtual void		receiving(UDPSocket& socket);
 	void				flush() { flush(0x4a, true, prevEngineType()); }
 	void				flush(bool echoTime) { flush(0x4a, echoTime, prevEngineType()); }
 	void				flush(UInt8 marker, bool echoTime) { flush(marker, echoTime, prevEngineType()); }
@@ -90,10 +97,23 @@ protected:
 	
 	
 private:
-	
+	// raises the writers waiting to send, the pacing queue of the session
+	class Pacer : public Timers::Timer, virtual Object {
+	public:
+		Pacer(RTMFPSession& session) : _session(session) {}
+	private:
+		UInt32	onTimer(Int64 now) { _session.flushWriters(); return 0; }
+		RTMFPSession& _session;
+	};
 
 	void							manage();
 	void							packetHandler(PacketReader& packet);
+	// keepalive and timeouts
+	UInt32							onTimer(Int64 now);
+	// flush the writers to manage, those which can't send yet (congestion) come back in the queue
+	void							flushWriters();
+	// (re)arm the pacer for the next sending allowed by the congestion control
+	void							pace();
 
 	// Implementation of BandWriter
 	const PoolBuffers&				poolBuffers() { return invoker.poolBuffers; }
@@ -101,6 +121,10 @@ private:
 	std::shared_ptr<RTMFPWriter>	changeWriter(RTMFPWriter& writer);
 	bool							canWriteFollowing(RTMFPWriter& writer) { return _pLastWriter == &writer; }
 	void							close() { failSignal(); }
+	Timers&							timers() { return invoker.timers; }
+	UInt16							ping() { return peer.ping; }
+	RTMFPCongestion&				congestion() { return _congestion; }
+	void							manageWriter(RTMFPWriter& writer);
 	UInt32							availableToWrite() { return RTMFP_MAX_PACKET_SIZE - (_pSender ? _pSender->packet.size() : RTMFP_HEADER_SIZE); }
 
 	BinaryWriter&					writeMessage(UInt8 type,UInt16 length,RTMFPWriter* pWriter=NULL);
@@ -126,14 +150,21 @@ private:
 
 	std::map<UInt64,RTMFPFlow*>						_flows;
 	RTMFPFlow*										_pFlowNull;
+	// before the writers which use them until their deletion
+	RTMFPCongestion									_congestion;
+	Pacer											_pacer;
+	std::vector<UInt64>								_writersToManage;
 	std::map<UInt64,std::shared_ptr<RTMFPWriter> >	_flowWriters;
 	Writer*											_pLastWriter;
 	UInt64											_nextRTMFPWriterId;
 
-	RTMFPEngine::Type								_prevEngineType;
+	// read by the reactor threads in decode, so never changed after the construction
+	const RTMFPEngine::Type							_prevEngineType;
+	// serializes the decodes of this session received by different shards (handshake or peer address change)
+	std::mutex										_decodingMutex;
 
 	std::shared_ptr<RTMFPSender>					_pSender;
-	UDPSocket&										_socket;
+	UDPSocket*										_pSocket;
 
 	const std::shared_ptr<RTMFPKey>					_pDecryptKey;
 	const std::shared_ptr<RTMFPKey>					_pEncryptKey;
@@ -21,7 +21,6 @@ This file is a part of Mona.
 
 #include "Mona/Mona.h"
 #include "Mona/FlashWriter.h"
-#include "Mona/Trigger.h"
 #include "Mona/AMFReader.h"
 #include "Mona/Logs.h"
 #include "Mona/RTMFP/BandWriter.h"
@@ -37,7 +36,7 @@ This file is a part of Mona.
 namespace Mona {
 
 class Invoker;
-class RTMFPWriter : public FlashWriter, virtual Object {
+class RTMFPWriter : public FlashWriter, private Timers::Timer, virtual Object {
 public:
 	RTMFPWriter(const std::string& signature, BandWriter& band, WriterHandler* pHandler = NULL);
 	RTMFPWriter(const std::string& signature,BandWriter& band,std::shared_ptr<RTMFPWriter>& pThis,WriterHandler* pHandler=NULL);
@@ -66,6 +65,7 @@ public:
         _band.initWriter(pWriter);
 		_qos.reset();
 		_reseted = true;
+		_managing = false; // has now a new id
 	}
 
 	void				clear();
@@ -77,6 +77,7 @@ public:
 	State				state(State value=GET,bool minimal=false);
 
 	bool				writeMedia(MediaType type,UInt32 time,PacketReader& packet);
+	bool				writeMedia(MediaType type,UInt32 time,const std::shared_ptr<MediaFrame>& pFrame);
 	void				writeRaw(const UInt8* data,UInt32 size);
 	bool				writeMember(const Client& client);
 
@@ -84,22 +85,33 @@ private:
 	RTMFPWriter(RTMFPWriter& writer);
 	
 	UInt32					headerSize(UInt64 stage);
-	void					flush(BinaryWriter& writer,UInt64 stage,UInt8 flags,bool header,const UInt8* data,UInt16 size);
-
-	void					raiseMessage();
+	void					flush(BinaryWriter& writer,UInt64 stage,UInt8 flags,bool header,RTMFPMessage& message,UInt32 offset,UInt16 size);
+
+	bool					raiseMessage();
+	// arms the repetition of the messages not acknowledged, restart to begin again the cycles
+	void					repeat(bool restart);
+	UInt32					repeatDelay();
+	// pops the first fragment not acknowledged and deletes its message when all its fragments are released, returns the fragment size
+	UInt32					release(bool lost);
+	UInt32					onTimer(Int64 now);
+	void					manageLater() { if (!_managing) { _managing = true; _band.manageWriter(*this); } }
 	RTMFPMessageBuffered&	createBufferedMessage();
 	AMFWriter&				write(AMF::ContentType type,UInt32 time=0,PacketReader* pPacket=NULL);
+	void					write(AMF::ContentType type,UInt32 time,const std::shared_ptr<MediaFrame>& pFrame);
 
 	void					createReader(PacketReader& packet, std::shared_ptr<DataReader>& pReader) { pReader.reset(new AMFReader(packet)); }
 	void					createWriter(std::shared_ptr<DataWriter>& pWriter) { pWriter.reset(new AMFWriter(_band.poolBuffers()));pWriter->packet.next(6); }
 	bool					hasToConvert(DataReader& reader) { return dynamic_cast<AMFReader*>(&reader) == NULL; }
 
-	Trigger						_trigger;
+	UInt8						_repeatCycle;
+	bool						_managing;
+	UInt32						_sendingOffset; // bytes already sent of the first message to send
+	UInt32						_inFlight; // bytes sent and not yet acknowledged, counted in the congestion window of the band
 
 	int			 				_connectedSize;
 	std::deque<RTMFPMessage*>	_messages;
 	UInt64						_stage;
-	std::deque<RTMFPMessage*>	_messagesSent;
+	RTMFPFragments				_fragments;
 	UInt64						_stageAck;
 	UInt32						_lostCount;
 	UInt32						_ackCount;
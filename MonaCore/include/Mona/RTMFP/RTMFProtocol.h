@@ -29,13 +29,19 @@ namespace Mona {
 class RTMFProtocol : public UDProtocol, virtual Object  {
 public:
 	RTMFProtocol(const char* name, Invoker& invoker, Sessions& sessions) : UDProtocol(name, invoker, sessions) {}
+	virtual ~RTMFProtocol() { close(); }
 	
 	bool		load(Exception& ex, const RTMFPParams& params);
 
+	// the session has received its first packet, its cookie is not required anymore
+	void		commitCookie(const UInt8* value) { if (_pHandshake) _pHandshake->commitCookie(value); }
+
 private:
 	void		manage() { if (_pHandshake) _pHandshake->manage(); }
+	// packets are decoded by the reactor threads, until the posting of their RTMFPDecoding
+	bool		readsInReactor() const { return true; }
 	
-	void		onPacket(const UInt8* data, UInt32 size, const SocketAddress& address);
+	void		onPacket(UDPSocket& socket, const UInt8* data, UInt32 size, const SocketAddress& address);
 
 	std::unique_ptr<RTMFPHandshake>	_pHandshake;
 };
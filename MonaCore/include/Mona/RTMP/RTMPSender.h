@@ -21,16 +21,16 @@ This file is a part of Mona.
 
 #include "Mona/Mona.h"
 #include "Mona/Writer.h"
-#include "Mona/TCPSender.h"
+#include "Mona/TCPVectorSender.h"
 #include "Mona/AMFWriter.h"
 #include "Mona/RTMP/RTMP.h"
 
 
 namespace Mona {
 
-class RTMPSender : public TCPSender, virtual Object {
+class RTMPSender : public TCPVectorSender, virtual Object {
 public:
-	RTMPSender(const PoolBuffers& poolBuffers) : _writer(poolBuffers),sizePos(0),headerSize(0),TCPSender("RTMPSender") {}
+	RTMPSender(const PoolBuffers& poolBuffers) : _writer(poolBuffers),sizePos(0),headerSize(0),TCPVectorSender("RTMPSender") {}
 
 	UInt32				sizePos;
 	UInt8				headerSize;
@@ -42,9 +42,9 @@ public:
 	void				dump(RTMPChannel& channel,const SocketAddress& address) { pack(channel); Writer::DumpResponse(data(), size(), address); }
 
 	AMFWriter&			writer(RTMPChannel& channel) { pack(channel); return _writer; }
+	// write the size of the last message, payloadSize is the size of its payload sent separately
+	void				pack(RTMPChannel& channel,UInt32 payloadSize=0);
 private:
-	void				pack(RTMPChannel& channel);
-
 	AMFWriter			_writer;
 };
 
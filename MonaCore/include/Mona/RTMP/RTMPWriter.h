@@ -38,6 +38,7 @@ public:
 
 	void			writeRaw(const UInt8* data,UInt32 size);
 
+	bool			congested() { return _socket.congested(); }
 	void			flush(bool full=false);
 
 	void			writeAck(UInt32 count) {write(AMF::ACK).packet.write32(count);}
@@ -46,6 +47,8 @@ public:
 private:
 
 	AMFWriter&		write(AMF::ContentType type,UInt32 time=0,PacketReader* pData=NULL);
+	void			write(AMF::ContentType type,UInt32 time,const std::shared_ptr<MediaFrame>& pFrame);
+	AMFWriter&		writeHeader(AMF::ContentType type,UInt32 time,PacketReader* pData);
 
 	RTMPChannel						_channel;
 	std::shared_ptr<RTMPSender>&	_pSender;
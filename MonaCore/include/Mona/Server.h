@@ -34,12 +34,16 @@ private:
 	void run(Exception& ex);
 	void handle(Exception& ex);
 	Server& _server;
+	UInt64	_wakeUps;
+	UInt64	_events;
+	UInt64	_hits;
+	UInt64	_misses;
 };
 
 class Server : protected Handler,private Startable {
 	friend class ServerManager;
 public:
-	Server(UInt32 socketBufferSize=0,UInt16 threads=0);
+	Server(UInt32 socketBufferSize=0,UInt16 threads=0,UInt16 reactors=1);
 	virtual ~Server();
 
 	bool	start() { return start(params); }
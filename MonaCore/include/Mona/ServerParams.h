@@ -30,20 +30,28 @@ struct ProtocolParams {
 	std::string host;
 };
 
-struct HTTPParams : ProtocolParams {
-	HTTPParams() : ProtocolParams(80) {}
+struct TCPParams : ProtocolParams {
+	TCPParams(UInt16 port) : ProtocolParams(port),queueMaximum(4194304) {}
+	UInt32		queueMaximum; // bytes queued by session before to drop media frames, 0 means no limit
 };
 
-struct RTMPParams : ProtocolParams {
-	RTMPParams() : ProtocolParams(1935) {}
+struct HTTPParams : TCPParams {
+	HTTPParams() : TCPParams(80) {}
+};
+
+struct RTMPParams : TCPParams {
+	RTMPParams() : TCPParams(1935) {}
 };
 
 
 struct RTMFPParams : ProtocolParams {
-	RTMFPParams() : ProtocolParams(1935),keepAlivePeer(10),keepAliveServer(15) {}
+	RTMFPParams() : ProtocolParams(1935),keepAlivePeer(10),keepAliveServer(15),shards(1),batch(0),gso(false) {}
 
 	UInt16				keepAlivePeer;
 	UInt16				keepAliveServer;
+	UInt16				shards; // UDP sockets bound on the same port, 0 means one by socket reactor
+	UInt16				batch; // datagrams by recvmmsg/sendmmsg call, 0 disables it
+	bool				gso; // UDP segmentation offload of the batch mode
 };
 
 
@@ -22,6 +22,7 @@ This file is a part of Mona.
 #include "Mona/Mona.h"
 #include "Mona/Peer.h"
 #include "Mona/Invoker.h"
+#include <atomic>
 
 namespace Mona {
 
@@ -54,6 +55,7 @@ public:
 	template<typename DecodingType>
 	void decode(const std::shared_ptr<DecodingType>& pDecoding) {
 		shareThis(pDecoding->_expirableSession);
+		pDecoding->_pThis = pDecoding;
 		Exception ex;
 		_pDecodingThread = invoker.poolThreads.enqueue<DecodingType>(ex, pDecoding, _pDecodingThread);
 		if (ex)
@@ -85,6 +87,7 @@ private:
 	const std::string&  protocolName();
 
 	PoolThread*					_pDecodingThread;
+	std::atomic<UInt32>			_acquired; // by reactor threads, see Sessions::acquire
 	mutable std::string			_name;
 	UInt32						_id;
 	Sessions*					_pSessions;
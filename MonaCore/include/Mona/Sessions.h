@@ -25,6 +25,7 @@ This file is a part of Mona.
 #include "Mona/SocketAddress.h"
 #include "Mona/Logs.h"
 #include <cstddef>
+#include <mutex>
 
 namespace Mona {
 
@@ -51,6 +52,18 @@ public:
 
 	void		manage();
 
+	// Sessions are added and removed by the main thread, another thread acquires a session by id to use it:
+	// the lock covers just the lookup, the session stays alive until its release (remove waits it before to delete it)
+	template<typename SessionType = Session>
+	SessionType* acquire(UInt32 id) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		SessionType* pSession = find<SessionType>(id);
+		if (pSession)
+			++pSession->_acquired;
+		return pSession;
+	}
+	void		release(Session& session);
+
 	template<typename SessionType=Session>
 	SessionType* find(const SocketAddress& address) {
 		auto& it = _sessionsByAddress.find(address);
@@ -80,6 +93,7 @@ public:
 
 	template<typename SessionType>
 	SessionType& add(SessionType& session,UInt8 options=BYID) {
+		std::lock_guard<std::mutex> lock(_mutex);
 		session._id = _nextId;
 		_sessions[_nextId] = &session;
 		if (options&BYPEER)
@@ -97,12 +111,15 @@ public:
 private:
 
 	void    remove(std::map<UInt32,Session*>::iterator it);
+	// waits the releases of a session removed from _sessions, before to delete it
+	static void	Unacquire(Session& session);
 
 	UInt32									_nextId;
 	std::map<UInt32,Session*>				_sessions;
 	Entities<Session>::Map					_sessionsByPeerId;
 	std::map<SocketAddress,Session*>		_sessionsByAddress;
 	UInt32									_oldCount;
+	std::mutex								_mutex;
 };
 
 
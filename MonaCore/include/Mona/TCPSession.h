@@ -56,6 +56,8 @@ private:
 	UInt32			onReception(const UInt8* data, UInt32 size);
 	void			onError(const std::string& error);
 	void			onDisconnection() { kill(); }
+	void			onWriteBlocked();
+	void			onWriteDrained();
 
 	bool			_consumed;
 	bool			_decoding;
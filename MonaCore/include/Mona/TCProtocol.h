@@ -29,10 +29,13 @@ namespace Mona {
 
 class TCProtocol :public Protocol, protected TCPServer , virtual Object {
 public:
-	bool load(Exception& ex, const ProtocolParams& params);
+	bool load(Exception& ex, const TCPParams& params);
+
+	// send queue maximum of the sessions, see Socket::setQueueMaximum
+	UInt32	queueMaximum() const { return _queueMaximum; }
 
 protected:
-	TCProtocol(const char* name, Invoker& invoker, Sessions& sessions) : TCPServer(invoker.sockets), Protocol(name, invoker, sessions) {}
+	TCProtocol(const char* name, Invoker& invoker, Sessions& sessions) : TCPServer(invoker.sockets), Protocol(name, invoker, sessions), _queueMaximum(0) {}
 	virtual ~TCProtocol() {stop();}
 
 
@@ -41,9 +44,12 @@ private:
 	void	onError(const std::string& error) { WARN("Protocol ", name, ", ", error); }
 
 	bool    onConnection(const SocketAddress& address) { return auth(address); }
+
+	UInt32	_queueMaximum;
 };
 
-inline bool TCProtocol::load(Exception& ex, const ProtocolParams& params) {
+inline bool TCProtocol::load(Exception& ex, const TCPParams& params) {
+	_queueMaximum = params.queueMaximum;
 	SocketAddress address;
 	if (!address.setWithDNS(ex, params.host, params.port))
 		return false;
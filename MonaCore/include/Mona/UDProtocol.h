@@ -28,30 +28,98 @@ namespace Mona {
 
 class UDProtocol : public Protocol, public UDPSocket, virtual Object {
 public:
-	bool load(Exception& ex, const ProtocolParams& params);
+	/// shards>1 binds shards sockets on the same address with SO_REUSEPORT, the kernel hashes then the flows across them
+	/// (and SocketManager dispatches them on different reactors), 0 means one shard by socket reactor.
+	/// Shards are read by their reactor threads only if the protocol reads in reactor (see readsInReactor), else by the server thread.
+	/// batch>1 enables the recvmmsg/sendmmsg batch mode of each socket, and gso its UDP segmentation offload (Linux)
+	bool load(Exception& ex, const ProtocolParams& params, UInt16 shards = 1, UInt16 batch = 0, bool gso = false);
+
+	UInt16		shards() const { return (UInt16)_shards.size()+1; }
 
 protected:
 	UDProtocol(const char* name, Invoker& invoker, Sessions& sessions) : UDPSocket(invoker.sockets), Protocol(name, invoker, sessions) {}
+
+	// Returns true if onPacket is thread-safe, the protocol socket and its shards are then read by their reactor threads
+	virtual bool	readsInReactor() const { return false; }
+	// Closes the protocol socket and its shards, a protocol which reads in reactor calls it first in its destructor
+	// to wait the end of the readings in progress before to delete its members
+	void		close();
+
+	// buffer of the last reception of socket (which can be the protocol itself or one of its shards)
+	PoolBuffer&	rawBuffer(UDPSocket& socket);
 	
 private:
-	void		onReception(const UInt8* data, UInt32 size,const SocketAddress& address);
+	class Shard : public UDPSocket, virtual Object {
+	public:
+		Shard(UDProtocol& protocol) : UDPSocket(protocol.invoker.sockets), _protocol(protocol) {}
+		using UDPSocket::rawBuffer;
+	private:
+		bool	readsInReactor() const { return _protocol.readsInReactor(); }
+		void	onReception(const UInt8* data, UInt32 size, const SocketAddress& address) { _protocol.onReception(*this, data, size, address); }
+		void	onError(const std::string& error) { _protocol.onError(error); }
+		UDProtocol&	_protocol;
+	};
+
+	void		onReception(const UInt8* data, UInt32 size,const SocketAddress& address) { onReception(*this, data, size, address); }
+	void		onReception(UDPSocket& socket, const UInt8* data, UInt32 size,const SocketAddress& address);
 	void		onError(const std::string& error) { WARN("Protocol ",name,", ", error); }
 
-	virtual void onPacket(const UInt8* data, UInt32 size, const SocketAddress& address) = 0;
+	// socket is the shard which has received the packet, a session answers by the shard of its first packets
+	// and doesn't follow each packet (a flow stays on the same shard, except on an address change of the peer)
+	virtual void onPacket(UDPSocket& socket, const UInt8* data, UInt32 size, const SocketAddress& address) = 0;
+
+	std::vector<std::unique_ptr<Shard>>	_shards;
 };
 
-inline bool UDProtocol::load(Exception& ex, const ProtocolParams& params) {
+inline bool UDProtocol::load(Exception& ex, const ProtocolParams& params, UInt16 count, UInt16 batch, bool offload) {
 	SocketAddress address;
 	if (!address.setWithDNS(ex, params.host, params.port))
 		return false;
-	return bind(ex, address);
+	if (!bind(ex, address))
+		return false;
+	if (batch>1 && !setBatch(batch))
+		WARN("Protocol ", name, " can't batch its datagrams on this platform");
+	if (offload && (!UDPSocket::batch() || !setGSO(true)))
+		WARN("Protocol ", name, " can't use UDP segmentation offload, it requires the batch mode and a Linux 4.18 kernel");
+	if (count == 0)
+		count = invoker.sockets.reactors();
+	if (count<2)
+		return true;
+	if (!socket().getReusePort()) {
+		WARN("Protocol ", name, " can't be sharded, SO_REUSEPORT unsupported");
+		return true;
+	}
+	while (shards() < count) {
+		Exception exShard;
+		_shards.emplace_back(new Shard(*this));
+		_shards.back()->setBatch(UDPSocket::batch());
+		if (!_shards.back()->bind(exShard, address)) {
+			WARN("Protocol ", name, " shard ", _shards.size(), ", ", exShard.error());
+			_shards.pop_back();
+			break;
+		}
+		_shards.back()->setGSO(UDPSocket::gso());
+	}
+	DEBUG(name, " listens on ", shards(), " UDP sockets");
+	return true;
+}
+
+inline void UDProtocol::close() {
+	for (std::unique_ptr<Shard>& pShard : _shards)
+		pShard->close();
+	UDPSocket::close();
 }
 
+inline PoolBuffer& UDProtocol::rawBuffer(UDPSocket& socket) {
+	if (&socket == this)
+		return UDPSocket::rawBuffer();
+	return static_cast<Shard&>(socket).rawBuffer();
+}
 
-inline void	UDProtocol::onReception(const UInt8* data, UInt32 size, const SocketAddress& address) {
+inline void	UDProtocol::onReception(UDPSocket& socket, const UInt8* data, UInt32 size, const SocketAddress& address) {
 	if(!auth(address))
 		return;
-	onPacket(data, size,address);
+	onPacket(socket, data, size,address);
 }
 
 
@@ -36,6 +36,7 @@ public:
 	UInt16			ping;
 
 	State			state(State value=GET,bool minimal=false);
+	bool			congested() { return _socket.congested(); }
 	void			flush(bool full=false);
 
 	DataWriter&		writeInvocation(const std::string& name);
@@ -23,6 +23,7 @@ This file is a part of Mona.
 #include "Mona/DataReader.h"
 #include "Mona/QualityOfService.h"
 #include "Mona/PacketReader.h"
+#include "Mona/MediaFrame.h"
 #include <set>
 
 namespace Mona {
@@ -57,6 +58,8 @@ public:
 	bool					reliable;
 
 	const QualityOfService&	qos() { return _qos; }
+	// true when the transport can't follow, from the moment its send queue reaches its high-water mark and until it's drained
+	virtual bool			congested() { return false; }
 
 
 	virtual Writer&			newWriter(WriterHandler& handler) { _handlers.insert(&handler); return *this; }
@@ -71,6 +74,8 @@ public:
 	virtual void			close(int code=0);
 
 	virtual bool			writeMedia(MediaType type,UInt32 time,PacketReader& packet);
+	// audio or video frame shared by the listeners of a publication, by default written as a packet
+	virtual bool			writeMedia(MediaType type,UInt32 time,const std::shared_ptr<MediaFrame>& pFrame);
 	virtual bool			writeMember(const Client& client);
 
     virtual DataWriter&		writeInvocation(const std::string& name){return DataWriter::Null;}
@@ -56,6 +56,7 @@ bool AMFWriter::repeat(UInt32 reference) {
 
 void AMFWriter::writeString(const string& value) {
 	_lastReference=0;
+	packet.reserve(value.size()+6); // markers + size
 	if(!_amf3) {
 		if(amf0Preference) {
 			if(value.size()>65535) {
@@ -155,6 +156,7 @@ void AMFWriter::writeInteger(Int32 value){
 }
 
 void AMFWriter::writeBytes(const UInt8* data,UInt32 size) {
+	packet.reserve(size+6); // markers + size
 	if(!_amf3)
 		packet.write8(AMF_AVMPLUS_OBJECT); // switch in AMF3 format 
 	packet.write8(AMF3_BYTEARRAY); // bytearray in AMF3 format!
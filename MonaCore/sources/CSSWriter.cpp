@@ -119,7 +119,7 @@ void JSONWriter::writeBytes(const UInt8* data,UInt32 size) {
 	_first=false;
 	writer.writeRaw("{__raw:\"",8);
 
-	Buffer result;
+	InlineBuffer<> result;
 	Util::ToBase64(data, size, result);
 	writer.writeRaw(result.data(),result.size());
 	writer.writeRaw("\"}",2);
@@ -48,6 +48,7 @@ const UInt8* Decoding::decodeRaw(Exception& ex, PoolBuffer& pBuffer, UInt32 time
 bool Decoding::run(Exception& exc) {
 	UInt32 times(0);
 	UInt32 size(_size);
+	bool stable(stablePieces());
 	while(_size>0) {
 		Exception ex;
 		if (!(_current = decodeRaw(ex, _pBuffer, times++, _current, _size))) {
@@ -57,12 +58,22 @@ bool Decoding::run(Exception& exc) {
 		}
 		if (ex)
 			WARN(name,", ",ex.error())
-		waitHandle();
+		if (stable)
+			_pieces.emplace_back(_current, _size);
+		else
+			waitHandle();
 
 		_current += _size;
 		size -= _size;
 		_size = size;
 	}
+	if (_pieces.empty())
+		return true;
+	shared_ptr<Decoding> pThis(_pThis.lock());
+	if (pThis)
+		postHandle(shared_ptr<Task>(pThis, this));
+	else
+		waitHandle();
 	return true;
 }
 
@@ -71,11 +82,20 @@ void Decoding::handle(Exception& ex) {
 	Session* pSession = _expirableSession.safeThis(lock);
 	if (!pSession)
 		return;
-	PacketReader packet(_current, _size);
+	if (_pieces.empty()) {
+		receive(*pSession, _current, _size);
+		return;
+	}
+	for (const pair<const UInt8*, UInt32>& piece : _pieces)
+		receive(*pSession, piece.first, piece.second);
+}
+
+void Decoding::receive(Session& session, const UInt8* data, UInt32 size) {
+	PacketReader packet(data, size);
 	if (_address.host().isWildcard())
-		pSession->receive(packet);
+		session.receive(packet);
 	else
-		pSession->receive(packet, _address);
+		session.receive(packet, _address);
 }
 
 
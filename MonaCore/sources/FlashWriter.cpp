@@ -86,4 +86,22 @@ bool FlashWriter::writeMedia(MediaType type,UInt32 time,PacketReader& packet) {
 	return true;
 }
 
+bool FlashWriter::writeMedia(MediaType type,UInt32 time,const shared_ptr<MediaFrame>& pFrame) {
+	switch(type) {
+		case AUDIO:
+			write(AMF::AUDIO,time,pFrame);
+			return true;
+		case VIDEO:
+			write(AMF::VIDEO,time,pFrame);
+			return true;
+		default:
+			return Writer::writeMedia(type,time,pFrame);
+	}
+}
+
+void FlashWriter::write(AMF::ContentType type,UInt32 time,const shared_ptr<MediaFrame>& pFrame) {
+	PacketReader packet(pFrame->data(),pFrame->size());
+	write(type,time,&packet);
+}
+
 } // namespace Mona
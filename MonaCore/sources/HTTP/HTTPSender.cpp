@@ -28,12 +28,15 @@ This file is a part of Mona.
 
 using namespace std;
 
+// room reserved for the headers of a response
+#define HEADERS_RESERVE	256
+
 
 namespace Mona {
 
 
 
-HTTPSender::HTTPSender(const SocketAddress& address,const shared_ptr<HTTPPacket>& pRequest) : _pRequest(pRequest),_address(address),_sizePos(0),TCPSender("TCPSender"),_sortOptions(0) {
+HTTPSender::HTTPSender(const SocketAddress& address,const shared_ptr<HTTPPacket>& pRequest) : _pRequest(pRequest),_address(address),_sizePos(0),TCPVectorSender("HTTPSender"),_sortOptions(0) {
 	
 }
 
@@ -248,6 +251,8 @@ DataWriter& HTTPSender::writer(const string& code, HTTP::ContentType type, const
 	_pWriter.reset(type == HTTP::CONTENT_ABSENT ? new RawWriter(_pRequest->poolBuffers()) : HTTP::NewDataWriter(_pRequest->poolBuffers(),subType));
 
 	PacketWriter& packet = _pWriter->packet;
+	// headers + content in one allocation
+	packet.reserve(HEADERS_RESERVE + (data ? size : 0));
 
 	Exception ex;
 
@@ -128,5 +128,19 @@ bool HTTPWriter::writeMedia(MediaType type,UInt32 time,PacketReader& packet) {
 	return true;
 }
 
+bool HTTPWriter::writeMedia(MediaType type,UInt32 time,const shared_ptr<MediaFrame>& pFrame) {
+	if(state()==CLOSED)
+		return true;
+	if(mediaType!=MediaContainer::FLV || (type!=AUDIO && type!=VIDEO))
+		return Writer::writeMedia(type,time,pFrame);
+	// FLV tag around the frame, which is sent without being copied
+	HTTPSender& sender(createSender());
+	BinaryWriter& writer(sender.writeRaw(_tcpClient.socket().poolBuffers()));
+	MediaContainer::FLV::WriteTagHeader(writer,type,time,pFrame->size());
+	sender.reference(pFrame,pFrame->data(),pFrame->size());
+	MediaContainer::FLV::WriteTagFooter(writer,pFrame->size());
+	return true;
+}
+
 
 } // namespace Mona
@@ -26,8 +26,9 @@ using namespace std;
 namespace Mona {
 
 
-Invoker::Invoker(UInt32 socketBufferSize,UInt16 threads) : poolThreads(threads),relay(poolBuffers,poolThreads,socketBufferSize),sockets(*this,poolBuffers,poolThreads,socketBufferSize),publications(_publications),_nextId(0) {
+Invoker::Invoker(UInt32 socketBufferSize,UInt16 threads,UInt16 reactors) : poolThreads(threads),relay(poolBuffers,poolThreads,socketBufferSize),sockets(*this,poolBuffers,poolThreads,socketBufferSize,"SocketManager",reactors),publications(_publications),_nextId(0) {
 	DEBUG(poolThreads.threadsAvailable()," threads available in the server poolthreads");
+	DEBUG(sockets.reactors()," socket reactors");
 		
 }
 
@@ -76,7 +77,7 @@ FlashStream& Invoker::flashStream(UInt32 id,Peer& peer,shared_ptr<FlashStream>&
 }
 
 Publication* Invoker::publish(Exception& ex, Peer& peer,const string& name) {
-	auto& it(_publications.emplace(name, name).first);
+	auto& it(_publications.emplace(piecewise_construct, forward_as_tuple(name), forward_as_tuple(name, poolBuffers)).first);
 	Publication* pPublication = &it->second;
 	
 	pPublication->start(ex, peer);
@@ -101,7 +102,7 @@ void Invoker::unpublish(Peer& peer,const string& name) {
 }
 
 Listener* Invoker::subscribe(Exception& ex, Peer& peer,const string& name,Writer& writer,double start) {
-	auto& it(_publications.emplace(name, name).first);
+	auto& it(_publications.emplace(piecewise_construct, forward_as_tuple(name), forward_as_tuple(name, poolBuffers)).first);
 	Publication& publication(it->second);
 	Listener* pListener = publication.addListener(ex, peer,writer,start==-3000 ? true : false);
 	if (ex) {
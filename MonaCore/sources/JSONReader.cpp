@@ -226,7 +226,7 @@ JSONReader::Type JSONReader::followingType() {
 		packet.reset(pos);
 		packet.readRaw(size,_text);
 		if(_bool) {
-			Buffer result;
+			InlineBuffer<> result;
 			Util::FromBase64((const UInt8*)_text.c_str(), size, result);
 			_text.assign((const char*)result.data(),result.size());
 		}
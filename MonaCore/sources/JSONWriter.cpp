@@ -123,7 +123,7 @@ void JSONWriter::writeBytes(const UInt8* data,UInt32 size) {
 	_first=false;
 	packet.writeRaw("{__raw:\"");
 
-	Buffer result;
+	InlineBuffer<> result;
 	Util::ToBase64(data, size, result);
 	packet.writeRaw(result.data(),result.size());
 	packet.writeRaw("\"}");
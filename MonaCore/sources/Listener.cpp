@@ -30,7 +30,7 @@ namespace Mona {
 Listener::Listener(Publication& publication,Client& client,Writer& writer,bool unbuffered) : _droppedFrames(0),_unbuffered(unbuffered),
 	_writer(writer),publication(publication),_firstKeyFrame(false),receiveAudio(true),receiveVideo(true),client(client),
 	_pAudioWriter(NULL),_pVideoWriter(NULL),_pDataWriter(NULL),_publicationNamePacket((const UInt8*)publication.name().c_str(),publication.name().size()),
-	_time(0),_deltaTime(0),_addingTime(0),_bufferTime(0),_firstAudio(true),_firstVideo(true),_firstTime(true) {
+	_time(0),_deltaTime(0),_addingTime(0),_bufferTime(0),_firstAudio(true),_firstVideo(true),_firstTime(true),_congested(false) {
 }
 
 Listener::~Listener() {
@@ -163,7 +163,7 @@ void Listener::pushDataPacket(DataReader& reader) {
 		init();
 }
 
-void Listener::pushVideoPacket(PacketReader& packet,UInt32 time) {
+void Listener::pushVideoPacket(const shared_ptr<MediaFrame>& pFrame,UInt32 time) {
 	if(!receiveVideo) {
 		_firstKeyFrame=false;
 		_firstVideo=true;
@@ -172,12 +172,20 @@ void Listener::pushVideoPacket(PacketReader& packet,UInt32 time) {
 	if (!_pVideoWriter && !init())
 		return;
 
+	// congestion transition before the key frame test, a drained writer waits again a key frame which can be this one
+	if(_pVideoWriter->congested()) {
+		if(!_congested)
+			onWriteBlocked();
+	} else if(_congested)
+		onWriteDrained();
+
 	// key frame ?
-	if(MediaCodec::IsKeyFrame(packet.current(),packet.available()))
+	bool isKeyFrame(MediaCodec::IsKeyFrame(pFrame->data(),pFrame->size()));
+	if(isKeyFrame)
 		_firstKeyFrame=true;
 
-	if(!_firstKeyFrame) {
-		DEBUG("Video frame dropped to wait first key frame");
+	if(!_firstKeyFrame || (_congested && !isKeyFrame)) {
+		DEBUG("Video frame dropped to wait ", _congested ? "the writer drained" : "first key frame");
 		++_droppedFrames;
 		return;
 	}
@@ -187,7 +195,7 @@ void Listener::pushVideoPacket(PacketReader& packet,UInt32 time) {
 	if(_firstVideo) {
 		_firstVideo=false;
 		UInt32 size(0);
-		if(!MediaCodec::H264::IsCodecInfos(packet.current(),packet.available()) && (size=publication.videoCodecBuffer().size())>0) {
+		if(!MediaCodec::H264::IsCodecInfos(pFrame->data(),pFrame->size()) && (size=publication.videoCodecBuffer().size())>0) {
 			PacketReader videoCodecPacket(publication.videoCodecBuffer().data(),size);
 			// Reliable way for video codec packet!
 			bool reliable = _pVideoWriter->reliable;
@@ -198,12 +206,12 @@ void Listener::pushVideoPacket(PacketReader& packet,UInt32 time) {
 		}
 	}
 
-	if(!_pVideoWriter->writeMedia(Writer::VIDEO,time,packet))
+	if(!_pVideoWriter->writeMedia(Writer::VIDEO,time,pFrame))
 		init();
 }
 
 
-void Listener::pushAudioPacket(PacketReader& packet,UInt32 time) {
+void Listener::pushAudioPacket(const shared_ptr<MediaFrame>& pFrame,UInt32 time) {
 	if(!receiveAudio) {
 		_firstAudio=true;
 		return;
@@ -216,7 +224,7 @@ void Listener::pushAudioPacket(PacketReader& packet,UInt32 time) {
 	if(_firstAudio) {
 		_firstAudio=false;
 		UInt32 size(0);
-		if(!MediaCodec::AAC::IsCodecInfos(packet.current(),packet.available()) && (size=publication.audioCodecBuffer().size())>0) {
+		if(!MediaCodec::AAC::IsCodecInfos(pFrame->data(),pFrame->size()) && (size=publication.audioCodecBuffer().size())>0) {
 			PacketReader audioCodecPacket(publication.audioCodecBuffer().data(),size);
 			// Reliable way for audio codec packet!
 			bool reliable = _pAudioWriter->reliable;
@@ -227,10 +235,22 @@ void Listener::pushAudioPacket(PacketReader& packet,UInt32 time) {
 		}
 	}
 
-	if(!_pAudioWriter->writeMedia(Writer::AUDIO,time,packet))
+	if(!_pAudioWriter->writeMedia(Writer::AUDIO,time,pFrame))
 		init();
 }
 
+void Listener::onWriteBlocked() {
+	_congested = true;
+	INFO("Subscription ", publication.name(), " congested, its non-key video frames are dropped");
+}
+
+void Listener::onWriteDrained() {
+	_congested = false;
+	// the frames which follow reference the dropped frames, wait the next key frame
+	_firstKeyFrame = false;
+	INFO("Subscription ", publication.name(), " drained");
+}
+
 void Listener::flush() {
 	if(_pAudioWriter)
 		_pAudioWriter->flush();
@@ -44,6 +44,13 @@ void MediaContainer::FLV::Write(BinaryWriter& writer,UInt8 track) {
 
 // Writer audio or video packet
 void MediaContainer::FLV::Write(BinaryWriter& writer,UInt8 track,UInt32 time,const UInt8* data,UInt32 size) {
+	WriteTagHeader(writer, track, time, size);
+	/// playload
+	writer.writeRaw(data, size);
+	WriteTagFooter(writer, size);
+}
+
+void MediaContainer::FLV::WriteTagHeader(BinaryWriter& writer,UInt8 track,UInt32 time,UInt32 size) {
 	/// 11 bytes of header
 	writer.write8(track&AUDIO ? AMF::AUDIO : AMF::VIDEO);
 	// size on 3 bytes
@@ -52,10 +59,6 @@ void MediaContainer::FLV::Write(BinaryWriter& writer,UInt8 track,UInt32 time,con
 	writer.write24(time);
 	// unknown 4 bytes set to 0
 	writer.write32(0);
-	/// playload
-	writer.writeRaw(data, size);
-	/// footer
-	writer.write32(11+size);
 }
 
 ////////////////////  MPEG_TS  /////////////////////////////	
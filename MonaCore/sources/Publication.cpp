@@ -20,6 +20,7 @@ This file is a part of Mona.
 #include "Mona/Publication.h"
 #include "Mona/MediaCodec.h"
 #include "Mona/Logs.h"
+#include "Mona/Memory.h"
 
 using namespace std;
 
@@ -27,7 +28,17 @@ using namespace std;
 
 namespace Mona {
 
-Publication::Publication(const string& name):_new(false),_name(name),_droppedFrames(0),_firstKeyFrame(false),listeners(_listeners),_pPublisher(NULL) {
+// publications, with the codec configurations kept for the new listeners
+static Memory::Counter Publications("publications");
+
+static void SetCodec(Buffer& buffer, const UInt8* data, UInt32 size) {
+	Publications.add((Int64)size - buffer.size());
+	buffer.resize(size,false);
+	memcpy(buffer.data(),data,size);
+}
+
+Publication::Publication(const string& name,const PoolBuffers& poolBuffers):_poolBuffers(poolBuffers),_new(false),_name(name),_droppedFrames(0),_firstKeyFrame(false),listeners(_listeners),_pPublisher(NULL) {
+	Publications.add(0, 1);
 	DEBUG("New publication ",_name);
 }
 
@@ -37,6 +48,7 @@ Publication::~Publication() {
 	for(it=_listeners.begin();it!=_listeners.end();++it)
 		delete it->second;
 
+	Publications.add(-(Int64)(_audioCodecBuffer.size()+_videoCodecBuffer.size()), -1);
 	DEBUG("Publication ",_name," deleted");
 }
 
@@ -114,6 +126,7 @@ void Publication::stop(Peer& peer) {
 	_videoQOS.reset();
 	_audioQOS.reset();
 	_dataQOS.reset();
+	Publications.add(-(Int64)(_audioCodecBuffer.size()+_videoCodecBuffer.size()));
 	_videoCodecBuffer.clear();
 	_audioCodecBuffer.clear();
 	_droppedFrames=0;
@@ -154,7 +167,6 @@ void Publication::pushAudio(PacketReader& packet,UInt32 time,UInt32 numberLostFr
 		return;
 	}
 
-	int pos = packet.position();
 	if(numberLostFragments>0)
 		INFO(numberLostFragments," audio fragments lost on publication ",_name);
 	_audioQOS.add(_pPublisher->ping,packet.available()+4,packet.fragments,numberLostFragments); // 4 for time encoded
@@ -162,15 +174,16 @@ void Publication::pushAudio(PacketReader& packet,UInt32 time,UInt32 numberLostFr
 	// save audio codec packet for future listeners
 	if (MediaCodec::AAC::IsCodecInfos(packet.current(),packet.available())) {
 		// AAC codec && settings codec informations
-		_audioCodecBuffer.resize(packet.available(),false);
-		memcpy(_audioCodecBuffer.data(),packet.current(),packet.available());
+		SetCodec(_audioCodecBuffer,packet.current(),packet.available());
 	}
 
 	_new = true;
-	auto it = _listeners.begin();
-	while(it!=_listeners.end()) {
-		(it++)->second->pushAudioPacket(packet,time);  // listener can be removed in this call
-		packet.reset(pos);
+	if (!_listeners.empty()) {
+		// one copy shared by all the listeners
+		shared_ptr<MediaFrame> pFrame(new MediaFrame(_poolBuffers, packet.current(), packet.available()));
+		auto it = _listeners.begin();
+		while(it!=_listeners.end())
+			(it++)->second->pushAudioPacket(pFrame,time);  // listener can be removed in this call
 	}
 	_pPublisher->onAudioPacket(*this,time,packet);
 }
@@ -195,8 +208,7 @@ void Publication::pushVideo(PacketReader& packet,UInt32 time,UInt32 numberLostFr
 		// save video codec packet for future listeners
 		if (MediaCodec::H264::IsCodecInfos(packet.current(), packet.available())) {
 			// h264 codec && settings codec informations
-			_videoCodecBuffer.resize(packet.available(),false);
-			memcpy(_videoCodecBuffer.data(),packet.current(),packet.available());
+			SetCodec(_videoCodecBuffer,packet.current(),packet.available());
 		}
 	}
 
@@ -207,11 +219,12 @@ void Publication::pushVideo(PacketReader& packet,UInt32 time,UInt32 numberLostFr
 	}
 
 	_new = true;
-	int pos = packet.position();
-	auto it = _listeners.begin();
-	while(it!=_listeners.end()) {
-		(it++)->second->pushVideoPacket(packet,time); // listener can be removed in this call
-		packet.reset(pos);
+	if (!_listeners.empty()) {
+		// one copy shared by all the listeners
+		shared_ptr<MediaFrame> pFrame(new MediaFrame(_poolBuffers, packet.current(), packet.available()));
+		auto it = _listeners.begin();
+		while(it!=_listeners.end())
+			(it++)->second->pushVideoPacket(pFrame,time); // listener can be removed in this call
 	}
 	_pPublisher->onVideoPacket(*this,time,packet);
 }
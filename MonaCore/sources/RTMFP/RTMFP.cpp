@@ -19,54 +19,137 @@ This file is a part of Mona.
 
 #include "Mona/RTMFP/RTMFP.h"
 #include "Mona/Crypto.h"
+#include "Mona/Binary.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define RTMFP_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RTMFP_SSE2
+#endif
 
 
 using namespace std;
 
+// blocks summed in 32-bit lanes before to be added to the 64-bit sum (each lane takes 2 words by block)
+#define LANES_BLOCKS	16384
+
 
 namespace Mona {
 
 
 const shared_ptr<RTMFPKey>	RTMFPEngine::_pDefaultKey(new RTMFPKey(RTMFP_DEFAULT_KEY));
-RTMFPEngine RTMFPEngine::_DefaultDecrypt(_pDefaultKey,DECRYPT);
-RTMFPEngine RTMFPEngine::_DefaultEncrypt(_pDefaultKey,ENCRYPT);
+mutex						RTMFPEngine::_DefaultMutex;
 
 
-RTMFPEngine::RTMFPEngine(const std::shared_ptr<RTMFPKey>& pKey,Direction direction) : type(NORMAL),_direction(direction),_pKey(pKey) {
-	EVP_CIPHER_CTX_init(&_context);
+static void Cipher(EVP_CIPHER_CTX& context,const UInt8* in,UInt8* out,int size) {
+	static const UInt8 IV[RTMFP_KEY_SIZE] = {0};
+	// reset just the IV, the key schedule stays
+	EVP_CipherInit_ex(&context, NULL, NULL, NULL, IV, -1);
+	EVP_CipherUpdate(&context, out, &size, in, size);
 }
 
-RTMFPEngine::~RTMFPEngine() {
-	EVP_CIPHER_CTX_cleanup(&_context);
+RTMFPKey::RTMFPKey(const UInt8* key) {
+	memcpy(_key, key, RTMFP_KEY_SIZE);
+	for (UInt8 i = 0; i < 2; ++i) {
+		EVP_CIPHER_CTX_init(&_contexts[i]);
+		_keyed[i] = false;
+	}
 }
 
-void RTMFPEngine::process(const UInt8* in,UInt8* out,int size) {
-	if(type==DEFAULT) {
-		if(_direction==DECRYPT)
-			_DefaultDecrypt.process(in,out,size);
-		else
-			_DefaultEncrypt.process(in,out,size);
-		return;
+RTMFPKey::~RTMFPKey() {
+	for (EVP_CIPHER_CTX& context : _contexts)
+		EVP_CIPHER_CTX_cleanup(&context);
+}
+
+EVP_CIPHER_CTX& RTMFPKey::context(UInt8 direction) {
+	EVP_CIPHER_CTX& context(_contexts[direction]);
+	if (!_keyed[direction]) {
+		EVP_CipherInit_ex(&context, EVP_aes_128_cbc(), NULL, _key, NULL, direction);
+		EVP_CIPHER_CTX_set_padding(&context, 0); // RTMFP packets are already padded
+		_keyed[direction] = true;
 	}
-	static UInt8 IV[RTMFP_KEY_SIZE];
-	EVP_CipherInit_ex(&_context, EVP_aes_128_cbc(), NULL, _pKey->value(), IV,_direction);
-	EVP_CipherUpdate(&_context, out, &size, in, size);
+	return context;
 }
 
+void RTMFPEngine::process(const UInt8* in,UInt8* out,int size) {
+	unique_lock<mutex> lock(_DefaultMutex, defer_lock);
+	if (type==DEFAULT)
+		lock.lock();
+	Cipher((type==DEFAULT ? _pDefaultKey : _pKey)->context(_direction), in, out, size);
+}
 
 
 
-UInt16 RTMFP::CheckSum(PacketReader& packet) {
-	int sum = 0;
-	int pos = packet.position();
-	while(packet.available()>0)
-		sum += packet.available()==1 ? packet.read8() : packet.read16();
-	packet.reset(pos);
 
-  /* add back carry outs from top 16 bits to low 16 bits */
-  sum = (sum >> 16) + (sum & 0xffff);     /* add hi 16 to low 16 */
-  sum += (sum >> 16);                     /* add carry */
-  return ~sum; /* truncate to 16 bits */
+// sum of the 16-bit words of data in the native byte order (size is even), not folded
+static UInt64 Sum(const UInt8* data, UInt32 size) {
+	UInt64 sum(0);
+#if defined(RTMFP_AVX2)
+	const __m256i zero(_mm256_setzero_si256());
+	while (size >= 32) {
+		UInt32 blocks(min<UInt32>(size / 32, LANES_BLOCKS));
+		size -= blocks * 32;
+		__m256i lanes(zero);
+		while (blocks--) {
+			__m256i words(_mm256_loadu_si256((const __m256i*)data));
+			lanes = _mm256_add_epi32(lanes, _mm256_unpacklo_epi16(words, zero));
+			lanes = _mm256_add_epi32(lanes, _mm256_unpackhi_epi16(words, zero));
+			data += 32;
+		}
+		UInt32 values[8];
+		_mm256_storeu_si256((__m256i*)values, lanes);
+		for (UInt32 value : values)
+			sum += value;
+	}
+#elif defined(RTMFP_SSE2)
+	const __m128i zero(_mm_setzero_si128());
+	while (size >= 16) {
+		UInt32 blocks(min<UInt32>(size / 16, LANES_BLOCKS));
+		size -= blocks * 16;
+		__m128i lanes(zero);
+		while (blocks--) {
+			__m128i words(_mm_loadu_si128((const __m128i*)data));
+			lanes = _mm_add_epi32(lanes, _mm_unpacklo_epi16(words, zero));
+			lanes = _mm_add_epi32(lanes, _mm_unpackhi_epi16(words, zero));
+			data += 16;
+		}
+		UInt32 values[4];
+		_mm_storeu_si128((__m128i*)values, lanes);
+		for (UInt32 value : values)
+			sum += value;
+	}
+#endif
+	// 32-bit words give the same one's complement sum than 16-bit words
+	UInt32 value;
+	while (size >= 4) {
+		memcpy(&value, data, 4);
+		sum += value;
+		data += 4;
+		size -= 4;
+	}
+	if (size) {
+		UInt16 word;
+		memcpy(&word, data, 2);
+		sum += word;
+	}
+	return sum;
+}
+
+UInt16 RTMFP::CheckSum(const UInt8* data, UInt32 size) {
+	UInt64 sum(Sum(data, size & ~1));
+	// add back carry outs
+	while (sum >> 16)
+		sum = (sum >> 16) + (sum & 0xFFFF);
+#if !defined(_ARCH_BIG_ENDIAN)
+	// one's complement sum doesn't depend of the byte order, the little-endian sum has just to be flipped
+	sum = Binary::Flip16((UInt16)sum);
+#endif
+	if (size & 1) {
+		sum += data[size - 1];
+		sum = (sum >> 16) + (sum & 0xFFFF);
+	}
+	return ~(UInt16)sum;
 }
 
 
@@ -83,7 +166,7 @@ bool RTMFP::ReadCRC(PacketReader& packet) {
 	// Check the first 2 CRC bytes 
 	packet.reset(4);
 	UInt16 sum = packet.read16();
-	return (sum == CheckSum(packet));
+	return (sum == CheckSum(packet.current(),packet.available()));
 }
 
 
@@ -100,9 +183,7 @@ void RTMFP::Encode(RTMFPEngine& aesEncrypt,PacketWriter& packet) {
 
 void RTMFP::WriteCRC(PacketWriter& packet) {
 	// Compute the CRC and add it at the beginning of the request
-	PacketReader reader(packet.data(),packet.size());
-	reader.next(6);
-	UInt16 sum = CheckSum(reader);
+	UInt16 sum = CheckSum(packet.data()+6,packet.size()-6);
 	BinaryWriter(packet,4).write16(sum);
 }
 
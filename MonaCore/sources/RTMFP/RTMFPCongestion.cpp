@@ -0,0 +1,146 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+#include "Mona/RTMFP/RTMFPCongestion.h"
+#include "Mona/RTMFP/RTMFP.h"
+#include <cmath>
+
+
+using namespace std;
+
+// windows in bytes, CUBIC function in segments of one RTMFP packet (RFC 8312 constants)
+#define SEGMENT_SIZE		RTMFP_MAX_PACKET_SIZE
+#define WINDOW_INITIAL		(10*SEGMENT_SIZE)
+#define WINDOW_MIN			(2*SEGMENT_SIZE)
+#define WINDOW_MAX			(16*1024*1024)
+#define CUBIC_C				0.4
+#define CUBIC_BETA			0.7
+// pacing rate of one window by round-trip, faster in slow start to let the window grows
+#define PACING_SLOWSTART	2.0
+#define PACING_AVOIDANCE	1.25
+// if nothing is acknowledged during this time the bytes in flight are considered lost (unreliable fragments are never repeated)
+#define TIMEOUT_MIN			1000
+#define RTT_DEFAULT			100
+
+
+namespace Mona {
+
+void RTMFPCongestion::reset() {
+	_window = _initialWindow ? (_initialWindow > WINDOW_MAX ? WINDOW_MAX : _initialWindow) : WINDOW_INITIAL;
+	_threshold = WINDOW_MAX;
+	_windowMax = _windowTCP = _k = 0;
+	_epoch = _lastLoss = _lastAck = 0;
+	_inFlight = 0;
+	_rtt = 0;
+	_nextSending = 0;
+}
+
+double RTMFPCongestion::rate() const {
+	return _window * 1000 * (_window < _threshold ? PACING_SLOWSTART : PACING_AVOIDANCE) / (_rtt ? _rtt : RTT_DEFAULT);
+}
+
+UInt32 RTMFPCongestion::delay(Int64 now) {
+	if (_inFlight >= _window) {
+		// window full, waits an acknowledgment
+		UInt32 timeout(4 * (_rtt ? _rtt : RTT_DEFAULT));
+		if (timeout < TIMEOUT_MIN)
+			timeout = TIMEOUT_MIN;
+		if ((now - _lastAck) < timeout)
+			return UInt32(timeout - (now - _lastAck));
+		// timeout, restarts from the minimum window with the bytes in flight lost (repeatable ones will be repeated by their writers)
+		_threshold = _window * CUBIC_BETA;
+		if (_threshold < WINDOW_MIN)
+			_threshold = WINDOW_MIN;
+		_windowMax = _window;
+		_window = WINDOW_MIN;
+		_epoch = 0;
+		_lastLoss = _lastAck = now;
+		_inFlight = 0;
+	}
+	if (_nextSending <= now)
+		return 0;
+	return (UInt32)ceil(_nextSending - now);
+}
+
+void RTMFPCongestion::sent(Int64 now, UInt32 size, bool repeated) {
+	if (!repeated) {
+		if (!_inFlight)
+			_lastAck = now; // timeout counted from the first sending
+		_inFlight += size;
+	}
+	// no more than 1 ms of credit (resolution of timers) after a pause
+	if (_nextSending < (now - 1))
+		_nextSending = double(now - 1);
+	_nextSending += size * 1000 / rate();
+}
+
+void RTMFPCongestion::acknowledged(Int64 now, UInt32 size, UInt16 rtt) {
+	if (rtt)
+		_rtt = rtt;
+	// grows just if the window is used, else it could grow without limit for a sender which has few data
+	bool limited(_inFlight * 2 >= _window);
+	released(size);
+	_lastAck = now;
+	if (!limited)
+		return;
+
+	if (_window < _threshold) {
+		_window += size; // slow start, doubles by round-trip
+	} else {
+		if (!_epoch) {
+			_epoch = now;
+			if (_window < _windowMax)
+				_k = cbrt((_windowMax - _window) / SEGMENT_SIZE / CUBIC_C);
+			else {
+				_k = 0;
+				_windowMax = _window;
+			}
+			_windowTCP = _window;
+		}
+		// window expected one round-trip later
+		double t = (now - _epoch + (_rtt ? _rtt : RTT_DEFAULT)) / 1000.0 - _k;
+		double target = _windowMax + CUBIC_C * t * t * t * SEGMENT_SIZE;
+		// TCP friendly region, increases of 3(1-beta)/(1+beta) segment by round-trip
+		_windowTCP += 3 * (1 - CUBIC_BETA) / (1 + CUBIC_BETA) * SEGMENT_SIZE * size / _windowTCP;
+		if (target < _windowTCP)
+			target = _windowTCP;
+		else if (target > 1.5 * _window)
+			target = 1.5 * _window;
+		if (target > _window)
+			_window += (target - _window) * size / _window;
+	}
+	if (_window > WINDOW_MAX)
+		_window = WINDOW_MAX;
+}
+
+void RTMFPCongestion::lost(Int64 now) {
+	if (_lastLoss && (now - _lastLoss) < (_rtt ? _rtt : RTT_DEFAULT))
+		return; // same congestion event
+	_lastLoss = now;
+	_epoch = 0;
+	// fast convergence, a window which decreases again releases some bandwidth for the other flows
+	_windowMax = _window < _windowMax ? (_window * (1 + CUBIC_BETA) / 2) : _window;
+	_window *= CUBIC_BETA;
+	if (_window < WINDOW_MIN)
+		_window = WINDOW_MIN;
+	_threshold = _window;
+}
+
+
+} // namespace Mona
@@ -26,7 +26,7 @@ using namespace std;
 
 namespace Mona {
 
-RTMFPCookie::RTMFPCookie(RTMFPHandshake& handshake,Invoker& invoker,const string& tag,const shared_ptr<Peer>& pPeer) : _invoker(invoker), _pComputingThread(NULL),_pCookieComputing(new RTMFPCookieComputing(handshake,invoker)),tag(tag),id(0),farId(0),pPeer(pPeer) {
+RTMFPCookie::RTMFPCookie(RTMFPHandshake& handshake,Invoker& invoker,const string& tag,const shared_ptr<Peer>& pPeer) : _invoker(invoker), _pComputingThread(NULL),_pCookieComputing(new RTMFPCookieComputing(handshake,invoker)),tag(tag),id(0),farId(0),pPeer(pPeer),pSocket(NULL) {
 	
 }
 
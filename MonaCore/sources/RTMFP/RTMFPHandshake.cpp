@@ -30,7 +30,7 @@ using namespace std;
 namespace Mona {
 
 RTMFPHandshake::RTMFPHandshake(RTMFProtocol& protocol, Sessions& sessions, Invoker& invoker) : RTMFPSession(protocol, invoker, 0, RTMFP_DEFAULT_KEY, RTMFP_DEFAULT_KEY, "RTMFPHandshake"),
-	_sessions(sessions),_pPeer(new Peer((Handler&)invoker)) {
+	_sessions(sessions),_pReceiver(&protocol),_pPeer(new Peer((Handler&)invoker)) {
 	
 	memcpy(_certificat,"\x01\x0A\x41\x0E",4);
 	Util::Random(&_certificat[4],64);
@@ -118,7 +118,7 @@ RTMFPSession* RTMFPHandshake::createSession(const UInt8* cookieValue) {
 	(UInt32&)farId = cookie.farId;
 
 	// Create session
-	RTMFPSession* pSession = &_sessions.add<RTMFPSession>(*new RTMFPSession(protocol<RTMFProtocol>(), invoker, farId, cookie.decryptKey(), cookie.encryptKey(),cookie.pPeer),Sessions::BYPEER | Sessions::BYADDRESS);
+	RTMFPSession* pSession = &_sessions.add<RTMFPSession>(*new RTMFPSession(protocol<RTMFProtocol>(), cookie.pSocket ? *cookie.pSocket : protocol<RTMFProtocol>(), invoker, farId, cookie.decryptKey(), cookie.encryptKey(),cookie.pPeer),Sessions::BYPEER | Sessions::BYADDRESS);
 	(UInt32&)cookie.id = pSession->id();
 
 	// response!
@@ -278,6 +278,7 @@ UInt8 RTMFPHandshake::handshakeHandler(UInt8 id,PacketReader& request,PacketWrit
 
 			RTMFPCookie& cookie(*itCookie->second);
 			((SocketAddress&)cookie.pPeer->address).set(peer.address);
+			cookie.pSocket = _pReceiver;
 
 			if(cookie.farId==0) {
 				((UInt32&)cookie.farId) = farId;
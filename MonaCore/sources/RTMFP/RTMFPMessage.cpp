@@ -0,0 +1,82 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+#include "Mona/RTMFP/RTMFPMessage.h"
+#include "Mona/Slab.h"
+#include "Mona/Memory.h"
+#include <cstring>
+
+using namespace std;
+
+
+namespace Mona {
+
+// messages waiting to be sent or acknowledged (their content is accounted with the buffers)
+static Memory::Counter Accounting("rtmfpMessages");
+
+static Slab& Messages() {
+	// blocks large enough for any message type
+	static Slab slab(max(max(sizeof(RTMFPMessageBuffered), sizeof(RTMFPMessageMedia)), sizeof(RTMFPMessageUnbuffered)), 256);
+	return slab;
+}
+
+void* RTMFPMessage::operator new(size_t size) {
+	Slab& slab(Messages());
+	Accounting.add(size, 1);
+	return size <= slab.blockSize() ? slab.allocate() : ::operator new(size);
+}
+
+void RTMFPMessage::operator delete(void* pMessage, size_t size) {
+	Slab& slab(Messages());
+	Accounting.add(-(Int64)size, -1);
+	if (size <= slab.blockSize())
+		slab.release(pMessage);
+	else
+		::operator delete(pMessage);
+}
+
+void RTMFPMessageUnbuffered::retain() {
+	if (!_buffer.empty() || !_size)
+		return;
+	memcpy(_buffer->data(), _data, _size);
+	_data = _buffer->data();
+}
+
+void RTMFPFragments::push(UInt64 stage, RTMFPMessage& message, UInt32 offset, UInt32 size) {
+	if (empty())
+		_front = _back = stage;
+	if (!_fragments || this->size() > _mask) {
+		// full, grows and places again the fragments on their new slots
+		UInt64 mask(_fragments ? (_mask * 2 + 1) : 15);
+		Fragment* fragments = new Fragment[mask + 1];
+		for (UInt64 current = _front; current < _back; ++current)
+			fragments[current & mask] = _fragments[current & _mask];
+		delete [] _fragments;
+		_fragments = fragments;
+		_mask = mask;
+	}
+	Fragment& fragment(_fragments[_back++ & _mask]);
+	fragment.pMessage = &message;
+	fragment.offset = offset;
+	fragment.size = size;
+	fragment.stage = stage;
+}
+
+
+} // namespace Mona
@@ -27,16 +27,24 @@ This file is a part of Mona.
 
 using namespace std;
 
+// the session sends a keepalive after 2 mn without client message, and fails after 6 mn
+#define KEEPALIVE_DELAY		120000
+#define TIMEOUT_DELAY		360000
+// repetition of the keepalive and fail messages
+#define REPEAT_DELAY		2000
+
 
 namespace Mona {
 
 RTMFPSession::RTMFPSession(RTMFProtocol& protocol,
+				UDPSocket& socket,
 				Invoker& invoker,
 				UInt32 farId,
 				const UInt8* decryptKey,
 				const UInt8* encryptKey,
-				const shared_ptr<Peer>& pPeer) : _failed(false),_pThread(NULL), _socket(protocol), farId(farId), Session(protocol, invoker, pPeer), _pDecryptKey(new RTMFPKey(decryptKey)), _pEncryptKey(new RTMFPKey(encryptKey)), _timesFailed(0), _timeSent(0), _nextRTMFPWriterId(0), _timesKeepalive(0), _pLastWriter(NULL), _prevEngineType(RTMFPEngine::NORMAL) {
+				const shared_ptr<Peer>& pPeer) : _failed(false),_pThread(NULL), _pSocket(&socket), farId(farId), Session(protocol, invoker, pPeer), _pDecryptKey(new RTMFPKey(decryptKey)), _pEncryptKey(new RTMFPKey(encryptKey)), _timesFailed(0), _timeSent(0), _nextRTMFPWriterId(0), _timesKeepalive(0), _pLastWriter(NULL), _prevEngineType(farId == 0 ? RTMFPEngine::DEFAULT : RTMFPEngine::NORMAL), _pacer(*this) {
 	_pFlowNull = new RTMFPFlow(0,"",peer,invoker,*this);
+	invoker.timers.set(*this, KEEPALIVE_DELAY);
 }
 
 RTMFPSession::RTMFPSession(RTMFProtocol& protocol,
@@ -44,7 +52,7 @@ RTMFPSession::RTMFPSession(RTMFProtocol& protocol,
 				UInt32 farId,
 				const UInt8* decryptKey,
 				const UInt8* encryptKey,
-				const char* name) : _failed(false),_pThread(NULL), _socket(protocol), farId(farId), Session(protocol, invoker,name), _pDecryptKey(new RTMFPKey(decryptKey)), _pEncryptKey(new RTMFPKey(encryptKey)), _timesFailed(0), _timeSent(0), _nextRTMFPWriterId(0), _timesKeepalive(0), _pLastWriter(NULL), _prevEngineType(RTMFPEngine::NORMAL) {
+				const char* name) : _failed(false),_pThread(NULL), _pSocket(&protocol), farId(farId), Session(protocol, invoker,name), _pDecryptKey(new RTMFPKey(decryptKey)), _pEncryptKey(new RTMFPKey(encryptKey)), _timesFailed(0), _timeSent(0), _nextRTMFPWriterId(0), _timesKeepalive(0), _pLastWriter(NULL), _prevEngineType(farId == 0 ? RTMFPEngine::DEFAULT : RTMFPEngine::NORMAL), _pacer(*this) {
 	_pFlowNull = new RTMFPFlow(0,"",peer,invoker,*this);
 }
 
@@ -64,8 +72,10 @@ void RTMFPSession::failSignal() {
 	flush(false); // We send immediatly the fail message
 
 	// After 6 mn we can considerated that the session is died!
-	if(_timesFailed==10 || _recvTimestamp.isElapsed(360000000))
+	if(_timesFailed==10 || _recvTimestamp.isElapsed(TIMEOUT_DELAY*1000ll))
 		kill();
+	else if (active()) // repeated until death
+		invoker.timers.set(*this, REPEAT_DELAY);
 }
 
 void RTMFPSession::kill() {
@@ -87,6 +97,8 @@ void RTMFPSession::kill() {
 	
 	// delete flowWriters
 	_flowWriters.clear();
+	cancel();
+	_pacer.cancel();
 }
 
 void RTMFPSession::manage() {
@@ -95,24 +107,36 @@ void RTMFPSession::manage() {
 
 	Session::manage();
 
-	if (_failed) {
-		failSignal();
+	if (_failed)
 		return;
-	}
 
-	// After 6 mn we considerate than the session has failed
-	if(_recvTimestamp.isElapsed(360000000)) {
-		fail("Timeout no client message");
-		return;
-	}
+	flushWriters();
+}
 
-	// To accelerate the deletion of peer ghost (mainly for netgroup efficient), starts a keepalive server after 2 mn
-	if(_recvTimestamp.isElapsed(120000000) && !keepAlive()) // TODO check it!
+void RTMFPSession::manageWriter(RTMFPWriter& writer) {
+	_writersToManage.emplace_back(writer.id);
+	if (!_pacer.active())
+		pace();
+}
+
+void RTMFPSession::pace() {
+	// at least 1 ms, the writers are raised after the current handle (or current timer)
+	Int64 now(Timers::Now());
+	UInt32 delay(_congestion.delay(now));
+	invoker.timers.set(_pacer, now, delay ? delay : 1);
+}
+
+void RTMFPSession::flushWriters() {
+	if (died || _failed)
 		return;
 
-	// Raise RTMFPWriter
-	auto it=_flowWriters.begin();
-	while (it != _flowWriters.end()) {
+	// just the writers which have something to manage (repetitions are raised by their timer)
+	vector<UInt64> writers;
+	writers.swap(_writersToManage);
+	for (UInt64 id : writers) {
+		auto it = _flowWriters.find(id);
+		if (it == _flowWriters.end())
+			continue;
 		Exception ex;
 		it->second->manage(ex, invoker);
 		if (ex) {
@@ -122,16 +146,37 @@ void RTMFPSession::manage() {
 			}
 			continue;
 		}
-		if (it->second->consumed()) {
-			_flowWriters.erase(it++);
-			continue;
-		}
-		++it;
+		if (it->second->consumed())
+			_flowWriters.erase(it);
 	}
 
 	flush();
 }
 
+UInt32 RTMFPSession::onTimer(Int64 now) {
+	if (died)
+		return 0;
+	if (_failed) {
+		failSignal();
+		return died ? 0 : REPEAT_DELAY;
+	}
+
+	UInt32 elapsed((UInt32)(_recvTimestamp.elapsed() / 1000));
+	// After 6 mn we considerate than the session has failed
+	if (elapsed >= TIMEOUT_DELAY) {
+		fail("Timeout no client message");
+		return died ? 0 : REPEAT_DELAY;
+	}
+
+	// To accelerate the deletion of peer ghost (mainly for netgroup efficient), starts a keepalive server after 2 mn
+	if (elapsed < KEEPALIVE_DELAY)
+		return KEEPALIVE_DELAY - elapsed; // next check when the client will be silent since 2 mn
+	if (!keepAlive()) // TODO check it!
+		return died ? 0 : REPEAT_DELAY;
+	flush();
+	return REPEAT_DELAY;
+}
+
 bool RTMFPSession::keepAlive() {
 	if(!peer.connected) {
 		fail("Timeout connection client");
@@ -182,12 +227,26 @@ void RTMFPSession::p2pHandshake(const string& tag,const SocketAddress& address,U
 	flush();
 }
 
-void RTMFPSession::decode(PoolBuffer& poolBuffer, const SocketAddress& address) {
-	_prevEngineType = farId == 0 ? RTMFPEngine::DEFAULT : RTMFPEngine::NORMAL;
-	shared_ptr<RTMFPDecoding> pRTMFPDecoding(new RTMFPDecoding(invoker, poolBuffer,_pDecryptKey,_prevEngineType));
+void RTMFPSession::decode(UDPSocket& socket, PoolBuffer& poolBuffer, const SocketAddress& address) {
+	// no session change here, socket is given to the decoding and rejoins the session in the main thread (see receiving)
+	lock_guard<mutex> lock(_decodingMutex);
+	shared_ptr<RTMFPDecoding> pRTMFPDecoding(new RTMFPDecoding(invoker, socket, poolBuffer,_pDecryptKey,_prevEngineType));
 	Session::decode<RTMFPDecoding>(pRTMFPDecoding,address);
 }
 
+void RTMFPSession::receiving(UDPSocket& socket) {
+	if (pRTMFPCookieComputing) {
+		protocol<RTMFProtocol>().commitCookie(pRTMFPCookieComputing->value);
+		pRTMFPCookieComputing.reset();
+	}
+	if (&socket == _pSocket)
+		return;
+	// The kernel keeps a flow on the same shard, another one means a new address of the peer (mobility):
+	// the session is moved on this shard, all the shards share the same address so the peer sees no change
+	DEBUG("RTMFPSession ", name(), " moves on the shard which receives now its packets");
+	_pSocket = &socket;
+}
+
 void RTMFPSession::flush(UInt8 marker,bool echoTime,RTMFPEngine::Type type) {
 	_pLastWriter=NULL;
 	if(!_pSender)
@@ -219,7 +278,7 @@ void RTMFPSession::flush(UInt8 marker,bool echoTime,RTMFPEngine::Type type) {
 		dumpResponse(packet.data() + 6, packet.size() - 6);
 
 		Exception ex;
-		_pThread = _socket.send<RTMFPSender>(ex, _pSender,_pThread);
+		_pThread = _pSocket->send<RTMFPSender>(ex, _pSender,_pThread);
 		if (ex)
 			ERROR("RTMFP flush, ", ex.error());
 	}
@@ -344,9 +403,12 @@ void RTMFPSession::packetHandler(PacketReader& packet) {
 				/// Acknowledgment
 				UInt64 id = message.read7BitLongValue();
 				RTMFPWriter* pRTMFPWriter = writer(id);
-				if(pRTMFPWriter)
+				if(pRTMFPWriter) {
 					pRTMFPWriter->acknowledgment(message);
-				else
+					// the congestion window has maybe released some writers waiting
+					if (!_writersToManage.empty())
+						pace();
+				} else
 					WARN("RTMFPWriter ",id," unfound for acknowledgment on session ",name());
 				break;
 			}
@@ -26,15 +26,20 @@ This file is a part of Mona.
 using namespace std;
 
 
+// first repetition delay is twice the round-trip time (1 sec if unknown), doubled on every cycle
+#define REPEAT_DELAY_MIN	200
+#define REPEAT_DELAY_MAX	8000
+#define REPEAT_CYCLES		8
+
 namespace Mona {
 
 
-RTMFPWriter::RTMFPWriter(const string& signature, BandWriter& band, shared_ptr<RTMFPWriter>& pThis, WriterHandler* pHandler) : FlashWriter(pHandler), id(0), _band(band), _reseted(true), critical(false), _stage(0), _stageAck(0), _boundCount(0), flowId(0), signature(signature), _repeatable(0), _lostCount(0), _ackCount(0), _connectedSize(-1) {
+RTMFPWriter::RTMFPWriter(const string& signature, BandWriter& band, shared_ptr<RTMFPWriter>& pThis, WriterHandler* pHandler) : FlashWriter(pHandler), id(0), _band(band), _reseted(true), critical(false), _stage(0), _stageAck(0), _boundCount(0), flowId(0), signature(signature), _repeatable(0), _lostCount(0), _ackCount(0), _connectedSize(-1), _repeatCycle(0), _managing(false), _sendingOffset(0), _inFlight(0) {
 	pThis.reset(this);
 	_band.initWriter(pThis);
 }
 
-RTMFPWriter::RTMFPWriter(const string& signature, BandWriter& band, WriterHandler* pHandler) : FlashWriter(pHandler), id(0), _band(band), _reseted(true), critical(false), _stage(0), _stageAck(0), _boundCount(0), flowId(0), signature(signature), _repeatable(0), _lostCount(0), _ackCount(0), _connectedSize(-1) {
+RTMFPWriter::RTMFPWriter(const string& signature, BandWriter& band, WriterHandler* pHandler) : FlashWriter(pHandler), id(0), _band(band), _reseted(true), critical(false), _stage(0), _stageAck(0), _boundCount(0), flowId(0), signature(signature), _repeatable(0), _lostCount(0), _ackCount(0), _connectedSize(-1), _repeatCycle(0), _managing(false), _sendingOffset(0), _inFlight(0) {
 	shared_ptr<RTMFPWriter> pThis(this);
 	_band.initWriter(pThis);
 }
@@ -43,9 +48,10 @@ RTMFPWriter::RTMFPWriter(RTMFPWriter& writer) : FlashWriter(writer),_band(writer
 		critical(false),_repeatable(writer._repeatable),_reseted(true),_connectedSize(-1),
 		_stage(writer._stage),_stageAck(writer._stageAck),id(writer.id),
 		_ackCount(writer._ackCount),_lostCount(writer._lostCount),
-		_boundCount(0),flowId(0),signature(writer.signature) {
+		_boundCount(0),flowId(0),signature(writer.signature),_repeatCycle(0),_managing(false),_sendingOffset(0),_inFlight(0) {
 	reliable = true;
 	close();
+	manageLater(); // the state copied can be already CLOSED
 }
 
 RTMFPWriter::~RTMFPWriter() {
@@ -56,26 +62,28 @@ RTMFPWriter::~RTMFPWriter() {
 }
 
 void RTMFPWriter::clear() {
-	// delete messages
-	RTMFPMessage* pMessage;
+	// delete messages, the ones sent are deleted with their last fragment (except the one partially sent)
+	while(!_fragments.empty()) {
+		RTMFPMessage& message(*_fragments.pop().pMessage);
+		++_lostCount;
+		if(--message.fragments>0 || (_sendingOffset && &message==_messages.front()))
+			continue;
+		if(message.repeatable)
+			--_repeatable;
+		delete &message;
+	}
 	while(!_messages.empty()) {
-		pMessage = _messages.front();
-		_lostCount += pMessage->fragments.size();
-		delete pMessage;
+		delete _messages.front();
 		_messages.pop_front();
 	}
-	while(!_messagesSent.empty()) {
-		pMessage = _messagesSent.front();
-		_lostCount += pMessage->fragments.size();
-		if(pMessage->repeatable)
-			--_repeatable;
-		delete pMessage;
-		_messagesSent.pop_front();
-	}
+	_sendingOffset = 0;
+	// these bytes will be never acknowledged
+	_band.congestion().released(_inFlight);
+	_inFlight = 0;
 	if(_stage>0) {
 		createBufferedMessage(); // Send a MESSAGE_ABANDONMENT just in the case where the receiver has been created
 		flush();
-		_trigger.stop();
+		cancel();
 	}
 }
 
@@ -85,6 +93,7 @@ void RTMFPWriter::close(int code) {
 	if(_stage>0 || _connectedSize>0 || _messages.size()>0)
 		createBufferedMessage(); // Send a MESSAGE_END just in the case where the receiver has been created (or will be created)
 	Writer::close(code);
+	manageLater(); // to release it once consumed
 }
 
 void RTMFPWriter::acknowledgment(PacketReader& packet) {
@@ -100,7 +109,6 @@ void RTMFPWriter::acknowledgment(PacketReader& packet) {
 
 	UInt64 stageAckPrec = _stageAck;
 	UInt64 stageReaden = packet.read7BitLongValue();
-	UInt64 stage = _stageAck+1;
 
 	if(stageReaden>_stage) {
 		ERROR("Acknowledgment received ",stageReaden," superior than the current sending stage ",_stage," on writer ",id);
@@ -128,114 +136,78 @@ void RTMFPWriter::acknowledgment(PacketReader& packet) {
 	bool header = true;
 	bool stop=false;
 
-	auto it=_messagesSent.begin();
-	while(!stop && it!=_messagesSent.end()) {
-		RTMFPMessage& message(**it);
+	RTMFPCongestion& congestion(_band.congestion());
+	Int64 now(Timers::Now());
+	UInt32 ackedSize(0), lostSize(0);
 
-		if(message.fragments.empty()) {
-			CRITIC("RTMFPMessage ",(stage+1)," is bad formatted on fowWriter ",id);
-			++it;
-			continue;
-		}
+	// ACK
+	while(!_fragments.empty() && _fragments.front()<=_stageAck)
+		ackedSize += release(false);
 
-		map<UInt32,UInt64>::iterator itFrag=message.fragments.begin();
-		while(message.fragments.end()!=itFrag) {
-			
-			// ACK
-			if(_stageAck>=stage) {
-				message.fragments.erase(message.fragments.begin());
-				itFrag=message.fragments.begin();
-				++_ackCount;
-				++stage;
-				continue;
+	// Lost ranges, fragments are reached directly by their stage
+	UInt64 stage = _stageAck+1;
+	while(!stop && packet.available()>0) {
+		lostCount = packet.read7BitLongValue()+1;
+		lostStage = stageReaden+1;
+		stageReaden = lostStage+lostCount+packet.read7BitLongValue();
+
+		// received stages before this lost range
+		if(lostStage>stage) {
+			if(repeated)
+				header=true;
+			else { // No repeated, it means that past lost packet was not repeatable, we can ack this intermediate received sequence
+				_stageAck = lostStage>_stage ? _stage : (lostStage-1);
+				while(!_fragments.empty() && _fragments.front()<lostStage)
+					ackedSize += release(false);
 			}
+		}
 
-			// Read lost informations
-			while(!stop) {
-				if(lostCount==0) {
-					if(packet.available()>0) {
-						lostCount = packet.read7BitLongValue()+1;
-						lostStage = stageReaden+1;
-						stageReaden = lostStage+lostCount+packet.read7BitLongValue();
-					} else {
-						stop=true;
-						break;
-					}
-				}
-				// check the range
-				if(lostStage>_stage) {
-					// Not yet sent
-					ERROR("Lost information received ",lostStage," have not been yet sent on writer ",id);
-					stop=true;
-				} else if(lostStage<=_stageAck) {
-					// already acked
-					--lostCount;
-					++lostStage;
-					continue;
-				}
+		for(;lostCount>0;--lostCount,++lostStage) {
+			// check the range
+			if(lostStage>_stage) {
+				// Not yet sent
+				ERROR("Lost information received ",lostStage," have not been yet sent on writer ",id);
+				stop=true;
 				break;
 			}
-			if(stop)
-				break;
-			
-			// lostStage > 0 and lostCount > 0
+			if(lostStage<=_stageAck)
+				continue; // already acked
 
-			if(lostStage!=stage) {
-				if(repeated) {
-					++stage;
-					++itFrag;
-					header=true;
-				} else // No repeated, it means that past lost packet was not repeatable, we can ack this intermediate received sequence
-					_stageAck = stage;
-				continue;
-			}
+			RTMFPFragments::Fragment& fragment(_fragments[lostStage]);
+			RTMFPMessage& message(*fragment.pMessage);
 
 			/// Repeat message asked!
 			if(!message.repeatable) {
-				if(repeated) {
-					++itFrag;
-					++stage;
+				if(repeated)
 					header=true;
-				} else {
-					INFO("RTMFPWriter ",id," : message ",stage," lost");
-					--_ackCount;
-					++_lostCount;
-					_stageAck = stage;
+				else {
+					INFO("RTMFPWriter ",id," : message ",lostStage," lost");
+					lostSize += release(true);
+					_stageAck = lostStage;
 				}
-				--lostCount;
-				++lostStage;
 				continue;
 			}
 
 			repeated = true;
-			// Don't repeate before that the receiver receives the itFrag->second sending stage
-			if(itFrag->second >= maxStageRecv) {
-				++stage;
+			// Don't repeate before that the receiver receives the sending stage of this fragment
+			if(fragment.stage >= maxStageRecv) {
 				header=true;
-				--lostCount;
-				++lostStage;
-				++itFrag;
 				continue;
 			}
 
 			// Repeat message
 
-			DEBUG("RTMFPWriter ",id," : stage ",stage," repeated");
-			UInt32 fragment(itFrag->first);
-			itFrag->second = _stage; // Save actual stage sending to wait that the receiver gets it before to retry
-			UInt32 contentSize = message.size() - fragment; // available
-			++itFrag;
+			DEBUG("RTMFPWriter ",id," : stage ",lostStage," repeated");
+			fragment.stage = _stage; // Save actual stage sending to wait that the receiver gets it before to retry
 
 			// Compute flags
 			UInt8 flags = 0;
-			if(fragment>0)
+			if(fragment.offset>0)
 				flags |= MESSAGE_WITH_BEFOREPART; // fragmented
-			if(itFrag!=message.fragments.end()) {
+			if((fragment.offset+fragment.size)<message.size())
 				flags |= MESSAGE_WITH_AFTERPART;
-				contentSize = itFrag->first - fragment;
-			}
 
-			UInt32 size = contentSize+4;
+			UInt32 size = fragment.size+4;
 			UInt32 availableToWrite(_band.availableToWrite());
 			if(!header && size>availableToWrite) {
 				_band.flush(false);
@@ -243,7 +215,7 @@ void RTMFPWriter::acknowledgment(PacketReader& packet) {
 			}
 
 			if(header)
-				size+=headerSize(stage);
+				size+=headerSize(lostStage);
 
 			if(size>availableToWrite)
 				_band.flush(false);
@@ -251,54 +223,90 @@ void RTMFPWriter::acknowledgment(PacketReader& packet) {
 			// Write packet
 			size-=3;  // type + timestamp removed, before the "writeMessage"
 			flush(_band.writeMessage(header ? 0x10 : 0x11,(UInt16)size)
-				,stage,flags,header,message.data()+fragment,contentSize);
+				,lostStage,flags,header,message,fragment.offset,fragment.size);
+			congestion.sent(now, fragment.size, true);
 			header=false;
-			--lostCount;
-			++lostStage;
-			++stage;
 		}
-
-		if(message.fragments.empty()) {
-			if(message.repeatable)
-				--_repeatable;
-			if(_ackCount>0) {
-				_qos.add((UInt32)(message.sendingTime/1000),message.size(),_ackCount,_lostCount);
-				_ackCount=_lostCount=0;
-			}
-			delete *it;
-			it=_messagesSent.erase(it);
-		} else
-			++it;
-	
+		stage = lostStage;
 	}
 
 	if(lostCount>0 && packet.available()>0)
 		ERROR("Some lost information received have not been yet sent on writer ",id);
 
+	// congestion control, fragments lost are popped too but don't make grow the window
+	_inFlight = (ackedSize + lostSize) < _inFlight ? (_inFlight - ackedSize - lostSize) : 0;
+	congestion.released(lostSize);
+	if (ackedSize)
+		congestion.acknowledged(now, ackedSize, _band.ping());
+	if (lostSize || repeated)
+		congestion.lost(now);
+	_qos.setCongestion(congestion.window(), congestion.rate());
+
 
 	// rest messages repeatable?
 	if(_repeatable==0)
-		_trigger.stop();
+		cancel();
 	else if(_stageAck>stageAckPrec || repeated)
-		_trigger.reset();
+		repeat(true);
 }
 
-void RTMFPWriter::manage(Exception& ex, Invoker& invoker) {
-	if(!consumed() && !_band.failed()) {
-		
-		if(_trigger.raise(ex))
-			raiseMessage();
-
-		if (ex) {
-			fail("RTMFPWriter can't deliver its data, "+ex.error());
-			return;
-		}
+UInt32 RTMFPWriter::release(bool lost) {
+	RTMFPFragments::Fragment& fragment(_fragments.pop());
+	if(lost)
+		++_lostCount;
+	else
+		++_ackCount;
+	RTMFPMessage& message(*fragment.pMessage);
+	// the message partially sent is still owned by _messages
+	if(--message.fragments>0 || (_sendingOffset && &message==_messages.front()))
+		return fragment.size;
+	if(message.repeatable)
+		--_repeatable;
+	if(_ackCount>0) {
+		_qos.add((UInt32)(message.sendingTime/1000),message.size(),_ackCount,_lostCount);
+		_ackCount=_lostCount=0;
 	}
+	delete &message;
+	return fragment.size;
+}
+
+void RTMFPWriter::manage(Exception& ex, Invoker& invoker) {
+	_managing = false;
 	if(critical && state()==CLOSED) {
 		ex.set(Exception::NETWORK, "Main flow writer closed, session is closing");
 		return;
 	}
 	flush();
+	if (state() == CLOSED && !consumed())
+		manageLater();
+}
+
+void RTMFPWriter::repeat(bool restart) {
+	if (!restart && active())
+		return;
+	_repeatCycle = 0;
+	_band.timers().set(*this, repeatDelay());
+}
+
+UInt32 RTMFPWriter::repeatDelay() {
+	UInt32 delay(_band.ping() ? 2 * _band.ping() : 1000);
+	if (delay < REPEAT_DELAY_MIN)
+		delay = REPEAT_DELAY_MIN;
+	delay <<= _repeatCycle;
+	return delay > REPEAT_DELAY_MAX ? REPEAT_DELAY_MAX : delay;
+}
+
+UInt32 RTMFPWriter::onTimer(Int64 now) {
+	if (consumed() || _band.failed())
+		return 0;
+	if (++_repeatCycle == REPEAT_CYCLES) {
+		fail("RTMFPWriter can't deliver its data, repeat trigger failed");
+		return 0;
+	}
+	if (!raiseMessage())
+		return 0;
+	flush(true);
+	return repeatDelay();
 }
 
 UInt32 RTMFPWriter::headerSize(UInt64 stage) { // max size header = 50
@@ -312,7 +320,7 @@ UInt32 RTMFPWriter::headerSize(UInt64 stage) { // max size header = 50
 }
 
 
-void RTMFPWriter::flush(BinaryWriter& writer,UInt64 stage,UInt8 flags,bool header,const UInt8* data,UInt16 size) {
+void RTMFPWriter::flush(BinaryWriter& writer,UInt64 stage,UInt8 flags,bool header,RTMFPMessage& message,UInt32 offset,UInt16 size) {
 	if(_stageAck==0 && header)
 		flags |= MESSAGE_HEADER;
 	if(size==0)
@@ -344,24 +352,22 @@ void RTMFPWriter::flush(BinaryWriter& writer,UInt64 stage,UInt8 flags,bool heade
 	}
 
 	if (size > 0)
-		writer.writeRaw(data, size);
+		message.write(writer, offset, size);
 }
 
-void RTMFPWriter::raiseMessage() {
+bool RTMFPWriter::raiseMessage() {
 	bool header = true;
 	bool stop = true;
 	bool sent = false;
-	UInt64 stage = _stageAck+1;
+	RTMFPCongestion& congestion(_band.congestion());
+	Int64 now(Timers::Now());
 
-	for(RTMFPMessage* pMessage : _messagesSent) {
-		RTMFPMessage& message(*pMessage);
-		
-		if(message.fragments.empty())
-			break;
+	for(UInt64 stage=_fragments.front();stage<_fragments.back();++stage) {
+		RTMFPFragments::Fragment& fragment(_fragments[stage]);
+		RTMFPMessage& message(*fragment.pMessage);
 
 		// not repeat unbuffered messages
 		if(!message.repeatable) {
-			stage += message.fragments.size();
 			header = true;
 			continue;
 		}
@@ -371,56 +377,45 @@ void RTMFPWriter::raiseMessage() {
 		if(stop) {
 			_band.flush(); // To repeat message, before we must send precedent waiting mesages
 			stop = false;
+			congestion.lost(now); // nothing acknowledged during the repetition delay
 		}
 
-		map<UInt32,UInt64>::const_iterator itFrag=message.fragments.begin();
-		UInt32 available = message.size()-itFrag->first;
-	
-		while(itFrag!=message.fragments.end()) {
-			UInt32 contentSize = available;
-			UInt32 fragment(itFrag->first);
-			++itFrag;
-
-			// Compute flags
-			UInt8 flags = 0;
-			if(fragment>0)
-				flags |= MESSAGE_WITH_BEFOREPART; // fragmented
-			if(itFrag!=message.fragments.end()) {
-				flags |= MESSAGE_WITH_AFTERPART;
-				contentSize = itFrag->first - fragment;
-			}
-
-			UInt32 size = contentSize+4;
+		// Compute flags
+		UInt8 flags = 0;
+		if(fragment.offset>0)
+			flags |= MESSAGE_WITH_BEFOREPART; // fragmented
+		if((fragment.offset+fragment.size)<message.size())
+			flags |= MESSAGE_WITH_AFTERPART;
 
-			if(header)
-				size+=headerSize(stage);
+		UInt32 size = fragment.size+4;
 
-			// Actual sending packet is enough large? Here we send just one packet!
-			if(size>_band.availableToWrite()) {
-				if(!sent)
-					ERROR("Raise messages on writer ",id," without sending!");
-				DEBUG("Raise message on writer ",id," finishs on stage ",stage);
-				return;
-			}
-			sent=true;
+		if(header)
+			size+=headerSize(stage);
 
-			// Write packet
-			size-=3;  // type + timestamp removed, before the "writeMessage"
-			flush(_band.writeMessage(header ? 0x10 : 0x11,(UInt16)size)
-				,stage++,flags,header,message.data()+fragment,contentSize);
-			available -= contentSize;
-			header=false;
+		// Actual sending packet is enough large? Here we send just one packet!
+		if(size>_band.availableToWrite()) {
+			if(!sent)
+				ERROR("Raise messages on writer ",id," without sending!");
+			DEBUG("Raise message on writer ",id," finishs on stage ",stage);
+			return true;
 		}
+		sent=true;
+
+		// Write packet
+		size-=3;  // type + timestamp removed, before the "writeMessage"
+		flush(_band.writeMessage(header ? 0x10 : 0x11,(UInt16)size)
+			,stage,flags,header,message,fragment.offset,fragment.size);
+		congestion.sent(now, fragment.size, true);
+		header=false;
 	}
 
-	if(stop)
-		_trigger.stop();
+	return !stop;
 }
 
 void RTMFPWriter::flush(bool full) {
 
-	if(_messagesSent.size()>100)
-		DEBUG("_messagesSent.size()=",_messagesSent.size());
+	if(_fragments.size()>100)
+		DEBUG("_fragments.size()=",_fragments.size());
 
 	if(state()==CONNECTING) {
 		ERROR("Violation policy, impossible to flush data on a connecting writer");
@@ -429,20 +424,26 @@ void RTMFPWriter::flush(bool full) {
 
 	// flush
 	bool header = !_band.canWriteFollowing(*this);
+	RTMFPCongestion& congestion(_band.congestion());
+	Int64 now(Timers::Now());
 
 	while(!_messages.empty()) {
 		RTMFPMessage& message(*_messages.front());
 
-		if(message.repeatable) {
-			++_repeatable;
-			_trigger.start();
-		}
-
-		UInt32 fragments= 0;
-		UInt32 available = message.size();
+		// a message can be sent in several times, fragment by fragment, following the congestion window and pacing
+		UInt32 fragments = _sendingOffset;
+		UInt32 available = message.size()-fragments;
 	
 		do {
 
+			if (congestion.delay(now)) {
+				// the band will manage again this writer when it will be able to send
+				manageLater();
+				if(full)
+					_band.flush();
+				return;
+			}
+
 			++_stage;
 
 			// Actual sending packet is enough large?
@@ -477,18 +478,26 @@ void RTMFPWriter::flush(bool full) {
 
 			// Write packet
 			size-=3; // type + timestamp removed, before the "writeMessage"
-			flush(_band.writeMessage(head ? 0x10 : 0x11,(UInt16)size,this),_stage,flags,head,message.data()+fragments,contentSize);
+			flush(_band.writeMessage(head ? 0x10 : 0x11,(UInt16)size,this),_stage,flags,head,message,fragments,contentSize);
 
 			
-			message.fragments[fragments] = _stage;
+			_fragments.push(_stage,message,fragments,contentSize);
+			++message.fragments;
 			message.sendingTime.update();
+			congestion.sent(now, contentSize);
+			_inFlight += contentSize;
 			available -= contentSize;
 			fragments += contentSize;
+			_sendingOffset = fragments;
 
 		} while(available>0);
 
-		_messagesSent.emplace_back(&message);
-		_messages.pop_front();
+		_sendingOffset = 0;
+		if(message.repeatable) {
+			++_repeatable;
+			repeat(false);
+		}
+		_messages.pop_front(); // now owned by its fragments
 	}
 
 	if(full)
@@ -519,6 +528,7 @@ RTMFPMessageBuffered& RTMFPWriter::createBufferedMessage() {
 	}
 	RTMFPMessageBuffered* pMessage = new RTMFPMessageBuffered(_band.poolBuffers(),reliable);
 	_messages.emplace_back(pMessage);
+	manageLater();
 	return *pMessage;
 }
 
@@ -549,6 +559,16 @@ AMFWriter& RTMFPWriter::write(AMF::ContentType type,UInt32 time,PacketReader* pP
 	return amf;
 }
 
+void RTMFPWriter::write(AMF::ContentType type,UInt32 time,const shared_ptr<MediaFrame>& pFrame) {
+	if(state()==CLOSED || signature.empty() || _band.failed()) // signature.empty() means that we are on the writer of FlowNull
+		return;
+	// reference the frame rather than copying it, it will be copied just in the packets sent
+	_messages.emplace_back(new RTMFPMessageMedia(type,time,pFrame,reliable));
+	manageLater();
+	if(!reliable && state()!=CONNECTING)
+		flush();
+}
+
 bool RTMFPWriter::writeMember(const Client& client) {
 	RTMFPMessageBuffered& message(createBufferedMessage());
 	message.writer().packet.write8(0x0b); // unknown
@@ -563,8 +583,13 @@ void RTMFPWriter::writeRaw(const UInt8* data,UInt32 size) {
 	}
 	if(state()==CLOSED || signature.empty() || _band.failed()) // signature.empty() means that we are on the writer of FlowNull
 		return;
-	_messages.emplace_back(new RTMFPMessageUnbuffered(data,size));
+	RTMFPMessageUnbuffered* pMessage(new RTMFPMessageUnbuffered(_band.poolBuffers(),data,size));
+	_messages.emplace_back(pMessage);
+	manageLater();
 	flush();
+	// not entirely sent (congestion window or pacing), it will be sent later when data will be released by the caller
+	if(!_messages.empty() && _messages.back()==pMessage)
+		pMessage->retain();
 }
 
 bool RTMFPWriter::writeMedia(MediaType type,UInt32 time,PacketReader& packet) {
@@ -582,5 +607,10 @@ bool RTMFPWriter::writeMedia(MediaType type,UInt32 time,PacketReader& packet) {
 	return _reseted ? false : result;
 }
 
+bool RTMFPWriter::writeMedia(MediaType type,UInt32 time,const shared_ptr<MediaFrame>& pFrame) {
+	bool result = FlashWriter::writeMedia(type,time,pFrame);
+	return _reseted ? false : result;
+}
+
 
 } // namespace Mona
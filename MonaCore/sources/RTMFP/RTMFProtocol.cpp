@@ -27,7 +27,7 @@ namespace Mona {
 
 
 bool RTMFProtocol::load(Exception& ex, const RTMFPParams& params) {
-	if (!UDProtocol::load(ex, params))
+	if (!UDProtocol::load(ex, params, params.shards, params.batch, params.gso))
 		return false;
 	(UInt16&)params.keepAliveServer *= 1000;
 	(UInt16&)params.keepAlivePeer *= 1000;
@@ -35,7 +35,7 @@ bool RTMFProtocol::load(Exception& ex, const RTMFPParams& params) {
 	return true;
 }
 
-void RTMFProtocol::onPacket(const UInt8* data, UInt32 size, const SocketAddress& address) {
+void RTMFProtocol::onPacket(UDPSocket& socket, const UInt8* data, UInt32 size, const SocketAddress& address) {
 
 	if (size<RTMFP_MIN_PACKET_SIZE) {
 		ERROR("Invalid RTMFP packet");
@@ -46,20 +46,19 @@ void RTMFProtocol::onPacket(const UInt8* data, UInt32 size, const SocketAddress&
 	UInt32 id = RTMFP::Unpack(packet);
 
 	// TRACE("RTMFP Session ",id);
-	
-	RTMFPSession* pSession = id == 0 ? _pHandshake.get() : sessions.find<RTMFPSession>(id);
+
+	// reactor thread: the session is acquired to prevent its deletion during the decode, without to lock the sessions
+	// (the decodes of a same session received by different shards are serialized by RTMFPSession::decode)
+	RTMFPSession* pSession = id == 0 ? _pHandshake.get() : sessions.acquire<RTMFPSession>(id);
 
 	if (!pSession) {
 		WARN("Unknown RTMFP session ", id);
 		return;
 	}
-	
-	if (pSession->pRTMFPCookieComputing) {
-		_pHandshake->commitCookie(pSession->pRTMFPCookieComputing->value);
-		pSession->pRTMFPCookieComputing.reset();
-	}
 
-	pSession->decode(rawBuffer(), address);
+	pSession->decode(socket, rawBuffer(socket), address);
+	if (id)
+		sessions.release(*pSession);
 }
 
 
@@ -24,11 +24,11 @@ using namespace std;
 
 namespace Mona {
 
-void RTMPSender::pack(RTMPChannel& channel) {
+void RTMPSender::pack(RTMPChannel& channel,UInt32 payloadSize) {
 	if (sizePos == 0)
 		return;
 	// writer the size of the precedent playload!
-	channel.bodySize = _writer.packet.size()-sizePos+4-headerSize;
+	channel.bodySize = _writer.packet.size()-sizePos+4-headerSize+payloadSize;
 	BinaryWriter(_writer.packet,sizePos).write24(channel.bodySize);
 	sizePos=0;
 }
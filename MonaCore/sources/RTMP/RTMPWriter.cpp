@@ -23,6 +23,9 @@ This file is a part of Mona.
 
 using namespace std;
 
+// under this size the frame payload is copied, a reference costs more than the copy
+#define REFERENCE_MINIMUM	1024
+
 
 namespace Mona {
 
@@ -88,6 +91,29 @@ void RTMPWriter::close(int code) {
 }
 
 AMFWriter& RTMPWriter::write(AMF::ContentType type,UInt32 time,PacketReader* pData) {
+	AMFWriter& writer(writeHeader(type,time,pData));
+	if(writer && pData) {
+		writer.packet.writeRaw(pData->current(),pData->available());
+        return AMFWriter::Null;
+	}
+	return writer;
+}
+
+void RTMPWriter::write(AMF::ContentType type,UInt32 time,const shared_ptr<MediaFrame>& pFrame) {
+	PacketReader packet(pFrame->data(),pFrame->size());
+	// RTMPE encrypts the sender in place, the payload has to be copied
+	if(_pEncryptKey || pFrame->size()<REFERENCE_MINIMUM) {
+		write(type,time,&packet);
+		return;
+	}
+	if(!writeHeader(type,time,&packet))
+		return;
+	// the frame will be sent behind its header (gather sending) without being copied
+	_pSender->pack(_channel,pFrame->size());
+	_pSender->reference(pFrame,pFrame->data(),pFrame->size());
+}
+
+AMFWriter& RTMPWriter::writeHeader(AMF::ContentType type,UInt32 time,PacketReader* pData) {
 	if(state()==CLOSED)
         return AMFWriter::Null;
 
@@ -145,11 +171,6 @@ AMFWriter& RTMPWriter::write(AMF::ContentType type,UInt32 time,PacketReader* pDa
 			}
 		}
 	}
-
-	if(pData) {
-		data.writeRaw(pData->current(),pData->available());
-        return AMFWriter::Null;
-	}
 	return writer;
 }
 
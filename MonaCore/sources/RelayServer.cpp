@@ -20,6 +20,8 @@ This file is a part of Mona.
 #include "Mona/RelayServer.h"
 #include "Mona/UDPSender.h"
 
+#define RELAY_BATCH	32
+
 using namespace std;
 
 
@@ -164,6 +166,10 @@ UInt16 RelayServer::add(const Peer& peer1,const SocketAddress& address1,const Pe
 			continue;
 		}
 
+		// relayed media are bursts of datagrams of a same flow, let the kernel coalesce them (GRO) and segment them (GSO) when possible
+		if (pSocket->setBatch(RELAY_BATCH) && pSocket->batch() && pSocket->setGRO(true) && pSocket->setGSO(true))
+			DEBUG("Turn server uses UDP offloads on ", port, " port")
+
 		if (ex)
 			WARN("Turn server listening on ", port," port, ",ex.error())
 		else
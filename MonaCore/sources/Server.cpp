@@ -27,7 +27,7 @@ using namespace std;
 namespace Mona {
 
 
-ServerManager::ServerManager(Server& server):_server(server),Task(server),Startable("ServerManager"){
+ServerManager::ServerManager(Server& server):_server(server),Task(server),Startable("ServerManager"),_wakeUps(0),_events(0),_hits(0),_misses(0){
 }
 
 void ServerManager::run(Exception& ex) {
@@ -39,9 +39,24 @@ void ServerManager::run(Exception& ex) {
 void ServerManager::handle(Exception& ex) {
 	_server.manage();
 	_server.relay.manage();
+
+	// sockets dispatching statistics
+	UInt64 wakeUps(_server.sockets.wakeUps()), events(_server.sockets.events());
+	if (wakeUps > _wakeUps)
+		TRACE("Sockets, ", events - _events, " events on ", wakeUps - _wakeUps, " wakeups (", (double)(events - _events) / (wakeUps - _wakeUps), " events by wakeup)");
+	_wakeUps = wakeUps;
+	_events = events;
+
+	// release the buffers unused since the last call, and pooling statistics
+	((PoolBuffers&)_server.poolBuffers).manage();
+	UInt64 hits(_server.poolBuffers.hits()), misses(_server.poolBuffers.misses());
+	if (hits + misses > _hits + _misses)
+		TRACE("Buffers, ", hits - _hits, " requests served by the pool and ", misses - _misses, " allocations");
+	_hits = hits;
+	_misses = misses;
 }
 
-Server::Server(UInt32 socketBufferSize,UInt16 threads) : Startable("Server"),Handler(socketBufferSize,threads),_protocols(*this),_manager(*this) {
+Server::Server(UInt32 socketBufferSize,UInt16 threads,UInt16 reactors) : Startable("Server"),Handler(socketBufferSize,threads,reactors),_protocols(*this),_manager(*this) {
 	DEBUG("Socket Buffer size of ",socketBufferSize," bytes")
 }
 
@@ -82,8 +97,12 @@ void Server::run(Exception& exc) {
 				ex.set(exWarn);
 			else if (exWarn)
 				WARN(exWarn.error());
-			while (!ex && sleep() != STOP)
+			// wake up on the tasks, or when the next timer is due
+			UInt32 delay(0);
+			while (!ex && sleep(delay) != STOP) {
 				giveHandle(ex);
+				delay = timers.raise();
+			}
 		} else
 			ex.set(exWarn);
 		if (ex)
@@ -29,7 +29,7 @@ using namespace std;
 namespace Mona {
 
 Session::Session(Protocol& protocol, Invoker& invoker, const shared_ptr<Peer>& pPeer, const char* name) : _pPeer(pPeer),peer(*_pPeer),_pSessions(NULL), dumpJustInDebug(false),
-	Expirable(this), _protocol(protocol), _name(name ? name : ""), invoker(invoker), _pDecodingThread(NULL), died(false), _id(0) {
+	Expirable(this), _protocol(protocol), _name(name ? name : ""), invoker(invoker), _pDecodingThread(NULL), _acquired(0), died(false), _id(0) {
 	((string&)peer.protocol) = protocol.name;
 	if(memcmp(peer.id,"\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0",ID_SIZE)==0)
 		Util::Random(peer.id,ID_SIZE);
@@ -37,7 +37,7 @@ Session::Session(Protocol& protocol, Invoker& invoker, const shared_ptr<Peer>& p
 }
 	
 Session::Session(Protocol& protocol, Invoker& invoker, const char* name) : dumpJustInDebug(false), _pSessions(NULL), _pPeer(new Peer((Handler&)invoker)),
-	Expirable(this),_protocol(protocol),_name(name ? name : ""), invoker(invoker), _pDecodingThread(NULL), died(false), _id(0), peer(*_pPeer) {
+	Expirable(this),_protocol(protocol),_name(name ? name : ""), invoker(invoker), _pDecodingThread(NULL), _acquired(0), died(false), _id(0), peer(*_pPeer) {
 	((string&)peer.protocol) = protocol.name;
 	if(memcmp(peer.id,"\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0",ID_SIZE)==0)
 		Util::Random(peer.id, ID_SIZE);
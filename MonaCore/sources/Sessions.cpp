@@ -20,6 +20,7 @@ This file is a part of Mona.
 #include "Mona/Sessions.h"
 #include "Mona/Session.h"
 #include "Mona/Logs.h"
+#include <thread>
 
 using namespace std;
 
@@ -35,10 +36,16 @@ Sessions::~Sessions() {
 	_sessionsByPeerId.clear();
 	if (!_sessions.empty())
 		WARN("sessions are deleting");
-	Iterator it;
-	for (it = begin(); it != end(); ++it)
-		delete it->second;
-	_sessions.clear();
+	map<UInt32,Session*> sessions;
+	{
+		lock_guard<std::mutex> lock(_mutex);
+		_sessions.swap(sessions);
+	}
+	// deleted out of the lock, a session can close a socket what waits the end of its reactor reading
+	for (auto& it : sessions) {
+		Unacquire(*it.second);
+		delete it.second;
+	}
 }
 
 void Sessions::remove(map<UInt32,Session*>::iterator it) {
@@ -48,8 +55,23 @@ void Sessions::remove(map<UInt32,Session*>::iterator it) {
 		_sessionsByPeerId.erase(session.peer.id);
 	if(session._sessionsOptions&BYADDRESS)
 		_sessionsByAddress.erase(session.peer.address);
+	{
+		lock_guard<std::mutex> lock(_mutex);
+		_sessions.erase(it);
+	}
+	// deleted out of the lock, a session can close a socket what waits the end of its reactor reading
+	Unacquire(session);
 	delete &session;
-	_sessions.erase(it);
+}
+
+void Sessions::release(Session& session) {
+	--session._acquired;
+}
+
+void Sessions::Unacquire(Session& session) {
+	// the session is not findable anymore, a reactor which has acquired it has just its decode to finish
+	while (session._acquired)
+		this_thread::yield();
 }
 
 void Sessions::updateAddress(Session& session, const SocketAddress& oldAddress) {
@@ -18,7 +18,7 @@ This file is a part of Mona.
 */
 
 #include "Mona/TCPSession.h"
-#include "Mona/Protocol.h"
+#include "Mona/TCProtocol.h"
 
 using namespace std;
 
@@ -27,12 +27,21 @@ namespace Mona {
 
 TCPSession::TCPSession(const SocketAddress& peerAddress, Protocol& protocol, Invoker& invoker) : TCPClient(peerAddress,invoker.sockets), Session(protocol, invoker),_consumed(false),_decoding(false) {
 	((SocketAddress&)peer.address).set(peerAddress);
+	socket().setQueueMaximum(((TCProtocol&)protocol).queueMaximum());
 }
 
 void TCPSession::onError(const string& error) {
 	WARN("Protocol ", protocol().name, ", ", error);
 }
 
+void TCPSession::onWriteBlocked() {
+	DEBUG("Protocol ", protocol().name, ", session ", name(), " congested");
+}
+
+void TCPSession::onWriteDrained() {
+	DEBUG("Protocol ", protocol().name, ", session ", name(), " drained");
+}
+
 UInt32 TCPSession::onReception(const UInt8* data, UInt32 size) {
 	if (died)
 		return 0;
@@ -72,6 +72,11 @@ bool Writer::writeMedia(MediaType type,UInt32 time,PacketReader& packet) {
 	return true;
 }
 
+bool Writer::writeMedia(MediaType type,UInt32 time,const shared_ptr<MediaFrame>& pFrame) {
+	PacketReader packet(pFrame->data(),pFrame->size());
+	return writeMedia(type,time,packet);
+}
+
 bool Writer::writeMember(const Client& client){
 	ERROR("writeMember method not supported by ",client.protocol," protocol")
 	return false;
@@ -26,6 +26,7 @@ This file is a part of Mona.
 #include "LUAMember.h"
 #include "Mona/Exceptions.h"
 #include "Mona/Files.h"
+#include "Mona/Memory.h"
 #include "MonaServer.h"
 #include <openssl/evp.h>
 #include "math.h"
@@ -351,6 +352,18 @@ int LUAInvoker::Get(lua_State *pState) {
 			lua_getglobal(pState, "m.s");
 		} else if (strcmp(name,"dir")==0) {
 			SCRIPT_WRITE_FUNCTION(&LUAInvoker::Dir)
+		} else if (strcmp(name,"memory")==0) {
+			// {name={bytes=,objects=},...} by subsystem
+			Script::UpdateMemory(pState);
+			lua_newtable(pState);
+			Memory::ForEach([pState](const Memory::Counter& counter) {
+				lua_newtable(pState);
+				lua_pushnumber(pState, (lua_Number)counter.bytes());
+				lua_setfield(pState, -2, "bytes");
+				lua_pushnumber(pState, counter.objects());
+				lua_setfield(pState, -2, "objects");
+				lua_setfield(pState, -2, counter.name);
+			});
 		}
 	SCRIPT_CALLBACK_RETURN
 }
@@ -33,6 +33,10 @@ int LUAQualityOfService::Get(lua_State *pState) {
 			SCRIPT_WRITE_NUMBER(qos.byteRate)
 		} else if (strcmp(name, "latency") == 0) {
 			SCRIPT_WRITE_NUMBER(qos.latency)
+		} else if (strcmp(name, "congestionWindow") == 0) {
+			SCRIPT_WRITE_NUMBER(qos.congestionWindow)
+		} else if (strcmp(name, "pacingRate") == 0) {
+			SCRIPT_WRITE_NUMBER(qos.pacingRate)
 		}
 	SCRIPT_CALLBACK_RETURN
 }
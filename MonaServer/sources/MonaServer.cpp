@@ -38,8 +38,8 @@ using namespace Mona;
 const string MonaServer::WWWPath("./");
 const string MonaServer::DataPath("./");
 
-MonaServer::MonaServer(TerminateSignal& terminateSignal, UInt32 socketBufferSize, UInt16 threads, UInt16 serversPort, const string& serversTarget) :
-	Server(socketBufferSize, threads), servers(serversPort, *this, sockets, serversTarget), _firstData(true),_data(this->poolBuffers),_terminateSignal(terminateSignal) {
+MonaServer::MonaServer(TerminateSignal& terminateSignal, UInt32 socketBufferSize, UInt16 threads, UInt16 reactors, UInt16 serversPort, const string& serversTarget) :
+	Server(socketBufferSize, threads, reactors), servers(serversPort, *this, sockets, serversTarget), _firstData(true),_data(this->poolBuffers),_terminateSignal(terminateSignal) {
 }
 
 
@@ -79,12 +79,18 @@ bool MonaServer::start(MapParameters& parameters) {
 	CONFIG_PROTOCOL_NUMBER(RTMFP, port);
 	CONFIG_PROTOCOL_NUMBER(RTMFP, keepAliveServer);
 	CONFIG_PROTOCOL_NUMBER(RTMFP, keepAlivePeer);
+	CONFIG_PROTOCOL_NUMBER(RTMFP, shards);
+	CONFIG_PROTOCOL_NUMBER(RTMFP, batch);
+	parameters.getBool("RTMFP.gso", params.RTMFP.gso);
+	parameters.setBool("RTMFP.gso", params.RTMFP.gso);
 
 	// RTMP
 	CONFIG_PROTOCOL_NUMBER(RTMP, port);
+	CONFIG_PROTOCOL_NUMBER(RTMP, queueMaximum);
 
 	// WebSocket
 	CONFIG_PROTOCOL_NUMBER(HTTP, port);
+	CONFIG_PROTOCOL_NUMBER(HTTP, queueMaximum);
 
 	createParametersCollection("m.c", parameters);
 	createParametersCollection("m.e", Util::Environment());
@@ -245,6 +251,8 @@ void MonaServer::onStop() {
 void MonaServer::manage() {
 	Server::manage();
 	servers.manage();
+	if (_pState)
+		Script::UpdateMemory(_pState);
 	if (!_pService)
 		return;
 	_pService->watchFile();
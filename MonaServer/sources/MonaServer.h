@@ -28,7 +28,7 @@ This file is a part of Mona.
 
 class MonaServer : public Mona::Server, private ServiceHandler, private ServerHandler, private Mona::DatabaseLoader {
 public:
-	MonaServer(Mona::TerminateSignal& terminateSignal, Mona::UInt32 socketBufferSize, Mona::UInt16 threads, Mona::UInt16 serversPort, const std::string& serversTarget);
+	MonaServer(Mona::TerminateSignal& terminateSignal, Mona::UInt32 socketBufferSize, Mona::UInt16 threads, Mona::UInt16 reactors, Mona::UInt16 serversPort, const std::string& serversTarget);
 
 	static const std::string				WWWPath;
 	static const std::string				DataPath;
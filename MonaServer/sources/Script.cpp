@@ -20,6 +20,7 @@ This file is a part of Mona.
 #include "Script.h"
 #include "Mona/Logs.h"
 #include "Mona/Util.h"
+#include "Mona/Memory.h"
 #include <math.h>
 extern "C" {
 	#include "luajit-2.0/lualib.h"
@@ -30,6 +31,8 @@ using namespace Mona;
 
 lua_Debug	Script::LuaDebug;
 
+static Memory::Counter LuaHeap("lua");
+
 const char* Script::LastError(lua_State *pState) {
 	int top = lua_gettop(pState);
 	if (top == 0)
@@ -121,8 +124,14 @@ lua_State* Script::CreateState() {
 }
 
 void Script::CloseState(lua_State* pState) {
-	if(pState)
-		lua_close(pState);
+	if(!pState)
+		return;
+	lua_close(pState);
+	LuaHeap.set(0, 0);
+}
+
+void Script::UpdateMemory(lua_State* pState) {
+	LuaHeap.set((UInt64)lua_gc(pState, LUA_GCCOUNT)*1024 + lua_gc(pState, LUA_GCCOUNTB), 1);
 }
 
 int Script::Pairs(lua_State* pState) {
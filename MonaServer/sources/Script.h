@@ -107,6 +107,8 @@ public:
 
 	static void			CloseState(lua_State* pState);
 	static lua_State*	CreateState();
+	// accounts the heap of the state in the "lua" memory counter
+	static void			UpdateMemory(lua_State* pState);
 ;
 
 	template<class CollectorType = Script, class LUAItemType = Script>
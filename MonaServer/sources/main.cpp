@@ -33,14 +33,23 @@ private:
 	int main(TerminateSignal& terminateSignal) {
 		
 		// starts the server
-		UInt16 threads(0),serversPort(0);
+		UInt16 threads(0),reactors(1),serversPort(0);
 		UInt32 socketBufferSize(0);
 		getNumber("socketBufferSize", socketBufferSize);
 		getNumber("threads", threads);
+		getNumber("reactors", reactors); // 0 means one reactor by processor
+		bool edgeTriggered(false);
+		getBool("edgeTriggered", edgeTriggered); // epoll edge-triggered mode (Linux)
+		bool hugePages(false);
+		getBool("hugePages", hugePages); // pooled buffers backed by huge pages (Linux)
 		string serversTargets;
 		getNumber("servers.port", serversPort);
 		getString("servers.targets", serversTargets);
-		MonaServer server(terminateSignal, socketBufferSize, threads, serversPort, serversTargets);
+		MonaServer server(terminateSignal, socketBufferSize, threads, reactors, serversPort, serversTargets);
+		if (edgeTriggered && !((SocketManager&)server.sockets).setEdgeTriggered(true))
+			WARN("Edge-triggered polling unsupported on this platform");
+		if (hugePages && !((PoolBuffers&)server.poolBuffers).setHugePages(true))
+			WARN("Huge pages unsupported on this platform");
 		if (server.start(*this)) {
 			terminateSignal.wait();
 			// Stop the server
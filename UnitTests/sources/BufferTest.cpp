@@ -19,10 +19,16 @@ This file is a part of Mona.
 
 #include "Test.h"
 #include "Mona/Buffer.h"
+#include "Mona/PacketWriter.h"
+#include "Mona/StopWatch.h"
+#include "Mona/Logs.h"
 
 using namespace Mona;
 using namespace std;
 
+#define PACKETS		2000
+#define HEADERS		"HTTP/1.1 200 OK\r\nServer: Mona\r\nConnection: keep-alive\r\nContent-Type: text/html\r\n\r\n"
+
 static void CheckBuffer(Buffer& buffer,UInt32 capacity=0) {
 	CHECK(buffer.capacity()==(capacity == 0 ? 64 : capacity))
 	CHECK(buffer.resize(10,false));
@@ -53,3 +59,75 @@ ADD_TEST(BufferTest, Fix) {
 	CHECK(buffer.size()>0);
 	CheckBuffer(buffer,sizeof(data));
 }
+
+ADD_TEST(BufferTest, Inline) {
+	InlineBuffer<> buffer;
+	// small buffer, no allocation
+	CHECK(buffer.size() == 0 && buffer.data() >= (UInt8*)&buffer && buffer.data() < (UInt8*)(&buffer + 1));
+	CHECK(buffer.resize(64, false) && buffer.capacity() == 64);
+	memset(buffer.data(), 'a', buffer.size());
+	CHECK(buffer.resize(65, true) && buffer.capacity() == 128);
+	CHECK(buffer.data() < (UInt8*)&buffer || buffer.data() >= (UInt8*)(&buffer + 1));
+	CHECK(buffer[63] == 'a');
+	CheckBuffer(buffer, 128);
+
+	InlineBuffer<16> big(1000);
+	CHECK(big.size() == 1000 && big.capacity() == 1000);
+
+	// the storage is in the InlineBuffer only
+	CHECK(sizeof(InlineBuffer<>) >= sizeof(Buffer) + 64);
+}
+
+ADD_TEST(BufferTest, Reserve) {
+	Buffer buffer;
+	CHECK(buffer.resize(10, false));
+	memcpy(buffer.data(), EXPAND_SIZE("abcdefghij"));
+	CHECK(buffer.reserve(1000) && buffer.capacity() == 1000 && buffer.size() == 10);
+	CHECK(memcmp(buffer.data(), EXPAND_SIZE("abcdefghij")) == 0);
+	CHECK(buffer.reserve(100) && buffer.capacity() == 1000);
+	UInt8* data(buffer.data());
+	CHECK(buffer.resize(1000, true) && buffer.data() == data);
+
+	// growth after a complete clip
+	Buffer clipped(64);
+	clipped.clip(64);
+	CHECK(clipped.capacity() == 0 && clipped.resize(10, false) && clipped.capacity() == 128);
+
+	UInt8 fixed[10];
+	Buffer fix(fixed, sizeof(fixed));
+	CHECK(!fix.reserve(11) && fix.capacity() == sizeof(fixed));
+}
+
+ADD_TEST(BufferTest, Performance) {
+	PoolBuffers poolBuffers;
+	Stopwatch bytesWatch, reservedWatch;
+	UInt32 size(strlen(HEADERS) * 100), bytesSize(0), reservedSize(0);
+
+	// writes byte by byte, as AMF and HTTP headers
+	bytesWatch.start();
+	for (UInt32 i = 0; i < PACKETS; ++i) {
+		PacketWriter packet(poolBuffers);
+		for (UInt32 j = 0; j < 100; ++j) {
+			for (const char* header = HEADERS; *header; ++header)
+				packet.write8(*header);
+		}
+		bytesSize += packet.size();
+	}
+	bytesWatch.stop();
+
+	// the same with a reserve hint
+	reservedWatch.start();
+	for (UInt32 i = 0; i < PACKETS; ++i) {
+		PacketWriter packet(poolBuffers);
+		packet.reserve(size);
+		for (UInt32 j = 0; j < 100; ++j) {
+			for (const char* header = HEADERS; *header; ++header)
+				packet.write8(*header);
+		}
+		reservedSize += packet.size();
+	}
+	reservedWatch.stop();
+
+	CHECK(bytesSize == reservedSize && bytesSize == PACKETS * size);
+	NOTE("Byte by byte ", bytesWatch.elapsed(), "us, with reserve ", reservedWatch.elapsed(), "us (", PACKETS, " packets of ", size, " bytes)");
+}
@@ -0,0 +1,114 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+#include "Test.h"
+#include "Mona/FDTable.h"
+#include "Mona/StopWatch.h"
+#include "Mona/Logs.h"
+#include <thread>
+#include <vector>
+#include <map>
+#include <mutex>
+
+using namespace Mona;
+using namespace std;
+
+#define SOCKETS		100000
+#if defined(_WIN32)
+#define SOCKFD(i)	((NET_SOCKET)((i)+1)<<2) // windows handles are multiples of 4
+#else
+#define SOCKFD(i)	((NET_SOCKET)(i)+3)
+#endif
+
+ADD_TEST(FDTableTest, Slots) {
+	FDTable<UInt32> table;
+	UInt32 value1(1), value2(2);
+	CHECK(!table.find(SOCKFD(0)) && !table.erase(SOCKFD(0)));
+	CHECK(table.insert(SOCKFD(0), &value1) && !table.insert(SOCKFD(0), &value2)); // already set
+	CHECK(table.insert(SOCKFD(5000), &value2) && table.size() == 2);
+	CHECK(table.find(SOCKFD(0)) == &value1 && table.find(SOCKFD(5000)) == &value2 && !table.find(SOCKFD(1)));
+	CHECK(table.erase(SOCKFD(0)) == &value1 && !table.find(SOCKFD(0)) && table.size() == 1);
+	UInt32 cleared(0);
+	table.clear([&cleared](NET_SOCKET sockfd, UInt32* pValue) {
+		CHECK(sockfd == SOCKFD(5000) && *pValue == 2);
+		++cleared;
+	});
+	CHECK(cleared == 1 && table.size() == 0 && !table.find(SOCKFD(5000)));
+}
+
+ADD_TEST(FDTableTest, Concurrency) {
+	FDTable<UInt32> table;
+	vector<UInt32> values(SOCKETS);
+	vector<thread> threads;
+	// 4 threads insert and erase their own descriptors while the others do the same
+	for (UInt32 t = 0; t < 4; ++t) {
+		threads.emplace_back([&table, &values, t]() {
+			for (UInt32 round = 0; round < 2; ++round) {
+				for (UInt32 i = t; i < SOCKETS; i += 4)
+					table.insert(SOCKFD(i), &values[i]);
+				if (round == 0) {
+					for (UInt32 i = t; i < SOCKETS; i += 4)
+						table.erase(SOCKFD(i));
+				}
+			}
+		});
+	}
+	for (thread& worker : threads)
+		worker.join();
+	CHECK(table.size() == SOCKETS);
+	for (UInt32 i = 0; i < SOCKETS; ++i)
+		CHECK(table.find(SOCKFD(i)) == &values[i]);
+}
+
+// add/lookup/remove of 100k sockets, compared with the std::map under mutex used before by SocketManager
+ADD_TEST(FDTableTest, Bench) {
+	vector<UInt32> values(SOCKETS);
+	Stopwatch stopwatch;
+	UInt32 found(0);
+
+	FDTable<UInt32> table;
+	stopwatch.start();
+	for (UInt32 i = 0; i < SOCKETS; ++i)
+		table.insert(SOCKFD(i), &values[i]);
+	for (UInt32 i = 0; i < SOCKETS; ++i)
+		found += table.find(SOCKFD((i * 7919) % SOCKETS)) ? 1 : 0;
+	for (UInt32 i = 0; i < SOCKETS; ++i)
+		table.erase(SOCKFD(i));
+	stopwatch.stop();
+	Int64 tableTime(stopwatch.elapsed());
+
+	map<NET_SOCKET, UInt32*> sockets;
+	mutex sync;
+	stopwatch.restart();
+	for (UInt32 i = 0; i < SOCKETS; ++i) {
+		lock_guard<mutex> lock(sync);
+		sockets.emplace(SOCKFD(i), &values[i]);
+	}
+	for (UInt32 i = 0; i < SOCKETS; ++i) {
+		lock_guard<mutex> lock(sync);
+		found += sockets.find(SOCKFD((i * 7919) % SOCKETS)) != sockets.end() ? 1 : 0;
+	}
+	for (UInt32 i = 0; i < SOCKETS; ++i) {
+		lock_guard<mutex> lock(sync);
+		sockets.erase(SOCKFD(i));
+	}
+	stopwatch.stop();
+
+	CHECK(found == 2 * SOCKETS && table.size() == 0 && sockets.empty());
+	NOTE("FDTable ", tableTime, "us, std::map under mutex ", stopwatch.elapsed(), "us (", SOCKETS, " add, lookup and remove)");
+}
@@ -0,0 +1,87 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+#include "Test.h"
+#include "Mona/MPSCQueue.h"
+#include <thread>
+#include <vector>
+
+using namespace Mona;
+using namespace std;
+
+ADD_TEST(MPSCQueueTest, Order) {
+	MPSCQueue<UInt32> queue(4);
+	CHECK(queue.capacity() == 4);
+	UInt32 value(0);
+	CHECK(!queue.pop(value));
+	for (UInt32 i = 1; i <= 4; ++i)
+		CHECK(queue.tryPush(i));
+	CHECK(!queue.tryPush(5)); // full
+	for (UInt32 i = 1; i <= 4; ++i) {
+		CHECK(queue.pop(value) && value == i);
+	}
+	CHECK(!queue.pop(value));
+}
+
+ADD_TEST(MPSCQueueTest, Overflow) {
+	MPSCQueue<UInt32> queue(4);
+	UInt32 value(0);
+	// push never fails, the values which don't fit in the ring go in the overflow list
+	for (UInt32 i = 1; i <= 10; ++i)
+		queue.push(i);
+	CHECK(queue.pop(value) && value == 1);
+	CHECK(!queue.tryPush(11)); // the ring has room, but the order must be kept behind the overflowed values
+	for (UInt32 i = 2; i <= 10; ++i) {
+		CHECK(queue.pop(value) && value == i);
+	}
+	CHECK(!queue.pop(value));
+	CHECK(queue.tryPush(11) && queue.pop(value) && value == 11);
+}
+
+ADD_TEST(MPSCQueueTest, Producers) {
+	const UInt32 producers(4), count(200000);
+	MPSCQueue<UInt32> queue(1024); // small ring to test also the overflow
+
+	vector<thread> threads;
+	for (UInt32 producer = 0; producer < producers; ++producer) {
+		threads.emplace_back([&queue, producer, count]() {
+			for (UInt32 i = 0; i < count; ++i)
+				queue.push((producer << 24) | i);
+		});
+	}
+
+	// order must be kept by producer
+	vector<UInt32> nexts(producers, 0);
+	UInt32 received(0), value(0);
+	bool ordered(true);
+	while (received < producers*count) {
+		if (!queue.pop(value)) {
+			this_thread::yield();
+			continue;
+		}
+		UInt32 producer(value >> 24);
+		if (producer >= producers || (value & 0xFFFFFF) != nexts[producer]++)
+			ordered = false;
+		++received;
+	}
+	for (thread& producer : threads)
+		producer.join();
+	CHECK(ordered);
+	CHECK(!queue.pop(value));
+}
@@ -0,0 +1,118 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+#include "Test.h"
+#include "Mona/Memory.h"
+#include "Mona/PoolBuffer.h"
+#include "Mona/Logs.h"
+
+using namespace Mona;
+using namespace std;
+
+static Memory::Counter TestCounter("test");
+
+static const Memory::Counter* Find(const char* name) {
+	const Memory::Counter* pResult(NULL);
+	Memory::ForEach([name, &pResult](const Memory::Counter& counter) {
+		if (strcmp(counter.name, name) == 0)
+			pResult = &counter;
+	});
+	return pResult;
+}
+
+ADD_TEST(MemoryTest, Counter) {
+	CHECK(Find("test") == &TestCounter && TestCounter.bytes() == 0 && TestCounter.objects() == 0);
+	TestCounter.add(100, 2);
+	TestCounter.add(-40, -1);
+	CHECK(TestCounter.bytes() == 60 && TestCounter.objects() == 1);
+	TestCounter.set(0, 0);
+	CHECK(TestCounter.bytes() == 0 && TestCounter.objects() == 0);
+
+	{
+		Memory::Counter local("local");
+		CHECK(Find("local") == &local);
+	}
+	CHECK(!Find("local"));
+}
+
+ADD_TEST(MemoryTest, Buffers) {
+	const Memory::Counter* pBuffers(Find("buffers"));
+	const Memory::Counter* pPooled(Find("pooledBuffers"));
+	CHECK(pBuffers && pPooled);
+	UInt64 bytes(pBuffers->bytes()), objects(pBuffers->objects());
+	{
+		InlineBuffer<> small;
+		CHECK(pBuffers->bytes() == bytes); // inline
+		Buffer buffer(1000);
+		CHECK(pBuffers->bytes() == bytes + 1000 && pBuffers->objects() == objects + 1);
+		buffer.resize(1500, true);
+		CHECK(pBuffers->bytes() == bytes + 2000 && pBuffers->objects() == objects + 1);
+	}
+	CHECK(pBuffers->bytes() == bytes && pBuffers->objects() == objects);
+
+	PoolBuffers poolBuffers;
+	UInt64 pooled(pPooled->bytes());
+	{
+		PoolBuffer buffer(poolBuffers, 3000);
+		CHECK(buffer->size() == 3000 && pPooled->bytes() == pooled);
+	}
+	CHECK(pPooled->bytes() == pooled + 16384 && pPooled->objects() >= 1);
+	poolBuffers.clear();
+	CHECK(pPooled->bytes() == pooled);
+}
+
+ADD_TEST(MemoryTest, Chunks) {
+	const Memory::Counter* pBuffers(Find("buffers"));
+	const Memory::Counter* pChunks(Find("poolChunks"));
+	CHECK(pBuffers && pChunks);
+	PoolBuffers poolBuffers;
+	if (!poolBuffers.setHugePages(true))
+		return;
+	UInt64 bytes(pBuffers->bytes()), chunks(pChunks->bytes());
+	{
+		PoolBuffer buffer(poolBuffers, 3000);
+		if (buffer->size() != 3000 || !poolBuffers.chunksSize()) {
+			NOTE("PoolBuffers chunks unavailable");
+			return;
+		}
+		// counted one time, by its chunk
+		CHECK(pChunks->bytes() == chunks + poolBuffers.chunksSize() && pBuffers->bytes() == bytes);
+		// a resize leaves the chunk for the heap
+		buffer->resize(20000, true);
+		CHECK(pBuffers->bytes() == bytes + 32768);
+	}
+	poolBuffers.clear();
+	CHECK(pBuffers->bytes() == bytes);
+
+	// a buffer swapped to the PoolBuffer of another pool outlives its pool, its chunk is freed with it
+	PoolBuffers other;
+	{
+		PoolBuffer buffer(other);
+		{
+			PoolBuffers pool;
+			pool.setHugePages(true);
+			PoolBuffer chunkBuffer(pool, 3000);
+			CHECK(chunkBuffer->size() == 3000 && pool.chunksSize() > 0);
+			buffer.swap(chunkBuffer);
+		}
+		CHECK(buffer->size() == 3000 && pChunks->bytes() > chunks + poolBuffers.chunksSize());
+	}
+	other.clear();
+	CHECK(pChunks->bytes() == chunks + poolBuffers.chunksSize());
+}
@@ -0,0 +1,224 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+#include "Test.h"
+#include "Mona/PoolBuffer.h"
+#include "Mona/StopWatch.h"
+#include "Mona/Startable.h"
+#include "Mona/Logs.h"
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace Mona;
+using namespace std;
+
+#define REQUESTS	200000
+
+ADD_TEST(PoolBuffersTest, Classes) {
+	PoolBuffers poolBuffers;
+	CHECK(poolBuffers.classes() == 4);
+	{
+		PoolBuffer buffer1(poolBuffers, 10), buffer2(poolBuffers, 3000), buffer3(poolBuffers, 70000), buffer4(poolBuffers);
+		CHECK(buffer1->size() == 10 && buffer1->capacity() == 256);
+		CHECK(buffer2->size() == 3000 && buffer2->capacity() == 16384);
+		CHECK(buffer3->size() == 70000 && poolBuffers.unpooled() == 1); // too big, not pooled
+		CHECK(buffer4->size() == 0 && buffer4->capacity() == 256);
+	}
+	CHECK(poolBuffers.counters(0).available == 2 && poolBuffers.counters(2).available == 1 && poolBuffers.counters(3).available == 0);
+
+	// a buffer returns in the biggest class which it can serve
+	PoolBuffer buffer(poolBuffers, 100);
+	CHECK(buffer->capacity() == 256 && poolBuffers.counters(0).hits == 1);
+	CHECK(buffer->resize(5000, true) && buffer->capacity() == 8192);
+	buffer.release();
+	CHECK(poolBuffers.counters(0).available == 1 && poolBuffers.counters(1).available == 1);
+	CHECK(poolBuffers.hits() == 1 && poolBuffers.misses() == 3);
+
+	PoolBuffers smallPool(32768);
+	CHECK(smallPool.classes() == 3 && smallPool.counters(3).capacity == 0);
+	PoolBuffer unpooled(smallPool, 40000);
+	CHECK(unpooled->size() == 40000 && smallPool.unpooled() == 1);
+}
+
+ADD_TEST(PoolBuffersTest, Trim) {
+	PoolBuffers poolBuffers;
+	{
+		deque<PoolBuffer> buffers;
+		for (UInt32 i = 0; i < 40; ++i) {
+			buffers.emplace_back(poolBuffers, 2048);
+			buffers.back()->size();
+		}
+	}
+	// the thread cache keeps a part of them, the rest goes to the shared pool
+	PoolBuffers::Counters counters(poolBuffers.counters(1));
+	CHECK(counters.available == 40 && counters.misses == 40 && counters.hits == 0);
+	poolBuffers.manage(); // mark
+	CHECK(poolBuffers.counters(1).available == 40);
+	poolBuffers.manage(); // release the shared buffers unused since the mark
+	UInt32 cached(poolBuffers.counters(1).available);
+	CHECK(cached > 0 && cached < 40);
+	poolBuffers.manage(); // nothing more to release
+	CHECK(poolBuffers.counters(1).available == cached);
+
+	// the thread cache is trimmed the same way, on the first request of its thread following a manage
+	PoolBuffer(poolBuffers, 2048)->size(); // mark
+	CHECK(poolBuffers.counters(1).available == cached);
+	poolBuffers.manage();
+	PoolBuffer(poolBuffers, 2048)->size(); // release the cached buffers unused since the mark
+	CHECK(poolBuffers.counters(1).available == 1);
+
+	poolBuffers.clear();
+	CHECK(poolBuffers.counters(1).available == 0 && poolBuffers.hits() == 0 && poolBuffers.misses() == 0);
+	PoolBuffer buffer(poolBuffers, 2048);
+	CHECK(buffer->capacity() == 2048 && poolBuffers.misses() == 1);
+}
+
+ADD_TEST(PoolBuffersTest, Threads) {
+	PoolBuffers poolBuffers;
+	// buffers taken by one thread and released by another one come back through the shared pool
+	deque<PoolBuffer> buffers;
+	for (UInt32 i = 0; i < 100; ++i) {
+		buffers.emplace_back(poolBuffers, 1000);
+		buffers.back()->size();
+	}
+	thread([&buffers]() { buffers.clear(); }).join();
+	thread([&poolBuffers]() {
+		for (UInt32 i = 0; i < 50; ++i)
+			PoolBuffer(poolBuffers, 1000)->size();
+	}).join();
+	CHECK(poolBuffers.counters(1).misses == 100 && poolBuffers.counters(1).hits == 50);
+}
+
+class Requester : public Startable, virtual Object {
+public:
+	Requester(PoolBuffers& poolBuffers) : Startable("Requester"), _poolBuffers(poolBuffers) {}
+private:
+	void run(Exception& ex) {
+		deque<PoolBuffer> buffers;
+		for (UInt32 i = 0; i < 10; ++i) {
+			buffers.emplace_back(_poolBuffers, 1000);
+			buffers.back()->size();
+		}
+	}
+	PoolBuffers& _poolBuffers;
+};
+
+ADD_TEST(PoolBuffersTest, ThreadEnd) {
+	PoolBuffers poolBuffers;
+	Requester requester(poolBuffers);
+	Exception ex;
+	CHECK(requester.start(ex) && !ex);
+	requester.stop();
+	// the cache of an ended thread is flushed in the shared pool, its buffers (and counters) stay
+	CHECK(poolBuffers.counters(1).available == 10 && poolBuffers.counters(1).misses == 10);
+	PoolBuffer(poolBuffers, 1000)->size();
+	CHECK(poolBuffers.counters(1).hits == 1 && poolBuffers.counters(1).misses == 10);
+}
+
+ADD_TEST(PoolBuffersTest, Pools) {
+	// a thread has one cache by pool, more pools than the slots of its fast lookup
+	vector<unique_ptr<PoolBuffers>> pools;
+	for (UInt32 i = 0; i < 10; ++i)
+		pools.emplace_back(new PoolBuffers());
+	for (UInt32 round = 0; round < 3; ++round) {
+		for (unique_ptr<PoolBuffers>& pPool : pools)
+			PoolBuffer(*pPool, 1000)->size();
+	}
+	for (unique_ptr<PoolBuffers>& pPool : pools)
+		CHECK(pPool->counters(1).misses == 1 && pPool->counters(1).hits == 2 && pPool->counters(1).available == 1);
+}
+
+ADD_TEST(PoolBuffersTest, ClearRunning) {
+	PoolBuffers poolBuffers;
+	atomic<bool> running(true);
+	// clear empties the cache of a running thread without deleting it
+	thread requester([&poolBuffers, &running]() {
+		deque<PoolBuffer> buffers;
+		while (running) {
+			buffers.emplace_back(poolBuffers, 1000);
+			buffers.back()->size();
+			if (buffers.size() > 8)
+				buffers.pop_front();
+		}
+	});
+	for (UInt32 i = 0; i < 1000; ++i)
+		poolBuffers.clear();
+	running = false;
+	requester.join();
+	poolBuffers.clear();
+	CHECK(poolBuffers.counters(1).available == 0 && poolBuffers.hits() == 0 && poolBuffers.misses() == 0);
+}
+
+// every thread takes and releases buffers of all the classes
+ADD_TEST(PoolBuffersTest, Bench) {
+	PoolBuffers poolBuffers;
+	static const UInt32 Sizes[] = { 40, 1400, 200, 9000, 60000, 1200, 100, 1450 };
+	Stopwatch stopwatch;
+	stopwatch.start();
+	vector<thread> threads;
+	for (UInt32 t = 0; t < 4; ++t) {
+		threads.emplace_back([&poolBuffers]() {
+			deque<PoolBuffer> buffers;
+			for (UInt32 i = 0; i < REQUESTS; ++i) {
+				buffers.emplace_back(poolBuffers, Sizes[i % 8]);
+				buffers.back()->size();
+				if (buffers.size() > 8)
+					buffers.pop_front();
+			}
+		});
+	}
+	for (thread& worker : threads)
+		worker.join();
+	stopwatch.stop();
+	CHECK(poolBuffers.hits() + poolBuffers.misses() == 4 * REQUESTS && poolBuffers.misses() < 200);
+	NOTE("PoolBuffers ", stopwatch.elapsed(), "us (", 4 * REQUESTS, " requests on 4 threads, ", poolBuffers.misses(), " allocations)");
+}
+
+ADD_TEST(PoolBuffersTest, HugePages) {
+	PoolBuffers poolBuffers;
+	if (!poolBuffers.setHugePages(true)) {
+		NOTE("Huge pages not supported");
+		return;
+	}
+	{
+		deque<PoolBuffer> buffers;
+		for (UInt32 i = 0; i < 100; ++i) {
+			buffers.emplace_back(poolBuffers, 1000);
+			memset(buffers.back()->data(), i, 1000);
+		}
+		CHECK(poolBuffers.chunksSize() == 0x200000);
+		// a buffer which grows leaves its block for the heap
+		CHECK(buffers.front()->resize(10000, true) && buffers.front()->data()[999] == 0);
+		buffers.emplace_back(poolBuffers, 60000);
+		CHECK(buffers.back()->capacity() == 65536 && poolBuffers.chunksSize() == 0x400000);
+	}
+	// released in a thread of the same node, the blocks are reused
+	thread([&poolBuffers]() {
+		for (UInt32 i = 0; i < 50; ++i)
+			PoolBuffer(poolBuffers, 1000)->size();
+	}).join();
+	CHECK(poolBuffers.counters(1).hits == 50 && poolBuffers.chunksSize() == 0x400000);
+	poolBuffers.clear();
+	CHECK(poolBuffers.counters(1).available == 0);
+	PoolBuffer buffer(poolBuffers, 2000);
+	CHECK(buffer->capacity() == 2048 && poolBuffers.misses() == 1 && poolBuffers.chunksSize() == 0x400000);
+}
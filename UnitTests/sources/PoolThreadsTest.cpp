@@ -0,0 +1,137 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+#include "Test.h"
+#include "Mona/PoolThreads.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace Mona;
+using namespace std;
+
+// Defers one count to its PoolThread
+class DeferJob : public WorkThread, virtual Object {
+public:
+	DeferJob(atomic<UInt32>& deferred) : WorkThread("DeferJob"), _deferred(deferred) {}
+private:
+	bool run(Exception& ex) {
+		atomic<UInt32>& deferred(_deferred);
+		return PoolThread::Defer([&deferred]() { ++deferred; });
+	}
+	atomic<UInt32>&	_deferred;
+};
+
+class CountJob : public WorkThread, virtual Object {
+public:
+	CountJob(atomic<UInt32>& counter, vector<UInt32>& order, UInt32 value, UInt32 sleep = 0) : WorkThread("CountJob"), _counter(counter), _order(order), _value(value), _sleep(sleep) {}
+private:
+	bool run(Exception& ex) {
+		if (_sleep)
+			this_thread::sleep_for(chrono::milliseconds(_sleep));
+		_order.emplace_back(_value);
+		++_counter;
+		return true;
+	}
+	atomic<UInt32>&	_counter;
+	vector<UInt32>&	_order;
+	UInt32			_value;
+	UInt32			_sleep;
+};
+
+ADD_TEST(PoolThreadsTest, Affinity) {
+	PoolThreads poolThreads(4);
+	const UInt32 threads(16), jobs(5000);
+	atomic<UInt32> counter(0);
+	vector<vector<UInt32>> orders(threads);
+	vector<PoolThread*> pThreads(threads, NULL);
+	Exception ex;
+	for (UInt32 i = 0; i < jobs; ++i) {
+		for (UInt32 t = 0; t < threads; ++t)
+			pThreads[t] = poolThreads.enqueue<CountJob>(ex, make_shared<CountJob>(counter, orders[t], i), pThreads[t]);
+	}
+	CHECK(!ex);
+	poolThreads.join();
+	CHECK(counter == threads*jobs);
+	// jobs with the same PoolThread are run in order
+	for (const vector<UInt32>& order : orders) {
+		CHECK(order.size() == jobs);
+		for (UInt32 i = 0; i < order.size(); ++i)
+			CHECK(order[i] == i);
+	}
+}
+
+ADD_TEST(PoolThreadsTest, Stealing) {
+	PoolThreads poolThreads(2);
+	atomic<UInt32> slowCounter(0), counter(0);
+	vector<UInt32> slowOrder, order;
+	Exception ex;
+	// a long job must not delay the jobs of the other PoolThread
+	PoolThread* pSlowThread = poolThreads.enqueue<CountJob>(ex, make_shared<CountJob>(slowCounter, slowOrder, 0, 500));
+	PoolThread* pThread(NULL);
+	for (UInt32 i = 0; i < 100; ++i) {
+		pThread = poolThreads.enqueue<CountJob>(ex, make_shared<CountJob>(counter, order, i), pThread);
+		CHECK(pThread != pSlowThread);
+	}
+	UInt32 waited(0);
+	while (counter < 100 && waited++ < 300)
+		this_thread::sleep_for(chrono::milliseconds(1));
+	CHECK(counter == 100);
+	CHECK(slowCounter == 0);
+	poolThreads.join();
+	CHECK(slowCounter == 1);
+}
+
+ADD_TEST(PoolThreadsTest, Defer) {
+	PoolThreads poolThreads(2);
+	atomic<UInt32> deferred(0), counter(0);
+	vector<UInt32> order;
+	Exception ex;
+	CHECK(!PoolThread::Defer([]() {})); // not from a PoolThread job
+	// deferred functions run after the last job of the PoolThread
+	PoolThread* pThread = poolThreads.enqueue<CountJob>(ex, make_shared<CountJob>(counter, order, 0, 100));
+	for (UInt32 i = 0; i < 5; ++i)
+		poolThreads.enqueue<DeferJob>(ex, make_shared<DeferJob>(deferred), pThread);
+	pThread = poolThreads.enqueue<CountJob>(ex, make_shared<CountJob>(counter, order, 1), pThread);
+	CHECK(!ex);
+	UInt32 waited(0);
+	while (deferred < 5 && waited++ < 1000)
+		this_thread::sleep_for(chrono::milliseconds(1));
+	CHECK(deferred == 5 && counter == 2);
+	poolThreads.join();
+}
+
+ADD_TEST(PoolThreadsTest, JoinRace) {
+	PoolThreads poolThreads(2);
+	const UInt32 jobs(20000);
+	atomic<UInt32> counter(0);
+	vector<UInt32> order;
+	Exception ex;
+	// a job scheduled while join stops the workers is run all the same
+	thread scheduler([&]() {
+		PoolThread* pThread(NULL);
+		for (UInt32 i = 0; i < jobs; ++i)
+			pThread = poolThreads.enqueue<CountJob>(ex, make_shared<CountJob>(counter, order, i), pThread);
+	});
+	while (counter < jobs / 2)
+		poolThreads.join();
+	scheduler.join();
+	poolThreads.join();
+	CHECK(!ex && counter == jobs && order.size() == jobs);
+}
@@ -0,0 +1,191 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+#include "Test.h"
+#include "Mona/RTMFP/RTMFP.h"
+#include "Mona/RTMFP/RTMFPCongestion.h"
+#include "Mona/PoolBuffers.h"
+#include "Mona/StopWatch.h"
+#include "Mona/Logs.h"
+#include <deque>
+
+using namespace Mona;
+using namespace std;
+
+#define PACKETS		100000
+#define PAYLOAD		1100
+#define RTT			50
+
+// previous implementation, by 16-bit reads
+static UInt16 CheckSum(PacketReader& packet) {
+	int sum = 0;
+	while (packet.available() > 0)
+		sum += packet.available() == 1 ? packet.read8() : packet.read16();
+	sum = (sum >> 16) + (sum & 0xffff);
+	sum += (sum >> 16);
+	return ~sum;
+}
+
+// sends as much as the congestion allows during duration ms, everything sent is acknowledged one RTT later (if ack)
+static UInt32 Transmit(RTMFPCongestion& congestion, Int64& now, UInt32 duration, deque<pair<Int64, UInt32>>& flight, bool ack = true) {
+	UInt32 paced(0);
+	for (Int64 end = now + duration; now < end; ++now) {
+		while (ack && !flight.empty() && flight.front().first <= now) {
+			congestion.acknowledged(now, flight.front().second, RTT);
+			flight.pop_front();
+		}
+		UInt32 sent(0), rate((UInt32)congestion.rate()/1000);
+		while (!congestion.delay(now)) {
+			congestion.sent(now, PAYLOAD);
+			flight.emplace_back(now + RTT, PAYLOAD);
+			sent += PAYLOAD;
+		}
+		// no more than 2 ms of sendings (1 ms of credit), and nothing sent beyond the window
+		if (sent <= 2 * rate + PAYLOAD && (!sent || congestion.inFlight() <= congestion.window() + PAYLOAD))
+			++paced;
+	}
+	return paced;
+}
+
+static const UInt8 Key[RTMFP_KEY_SIZE] = { 0x10, 0x21, 0x32, 0x43, 0x54, 0x65, 0x76, 0x87, 0x98, 0xA9, 0xBA, 0xCB, 0xDC, 0xED, 0xFE, 0x0F };
+
+ADD_TEST(RTMFPTest, Engine) {
+	shared_ptr<RTMFPKey> pKey(new RTMFPKey(Key));
+	RTMFPEngine encoder(pKey, RTMFPEngine::ENCRYPT), decoder(pKey, RTMFPEngine::DECRYPT);
+	UInt8 plain[64], data[64], again[64];
+	for (UInt8 i = 0; i < sizeof(plain); ++i)
+		plain[i] = i;
+
+	// the IV is reset for each packet, so the same packet gives always the same result
+	encoder.process(plain, data, sizeof(data));
+	encoder.process(plain, again, sizeof(again));
+	CHECK(memcmp(plain, data, sizeof(data)) != 0 && memcmp(data, again, sizeof(data)) == 0);
+	decoder.process(data, data, sizeof(data));
+	CHECK(memcmp(plain, data, sizeof(data)) == 0);
+
+	// default engine
+	RTMFPEngine defaultEncoder(pKey, RTMFPEngine::ENCRYPT), checker(make_shared<RTMFPKey>(RTMFP_DEFAULT_KEY), RTMFPEngine::ENCRYPT);
+	defaultEncoder.type = RTMFPEngine::DEFAULT;
+	defaultEncoder.process(plain, data, sizeof(data));
+	checker.process(plain, again, sizeof(again));
+	CHECK(memcmp(data, again, sizeof(data)) == 0);
+}
+
+ADD_TEST(RTMFPTest, CheckSum) {
+	UInt8 data[RTMFP_MAX_PACKET_SIZE + 1];
+	UInt32 seed(12345);
+	for (UInt8& value : data)
+		value = (seed = seed * 1103515245 + 12345) >> 16;
+	// all the sizes and alignments
+	for (UInt32 offset = 0; offset < 33; ++offset) {
+		for (UInt32 size = 0; size <= RTMFP_MAX_PACKET_SIZE - offset; ++size) {
+			PacketReader reader(data + offset, size);
+			if (RTMFP::CheckSum(data + offset, size) != ::CheckSum(reader)) {
+				CHECK(RTMFP::CheckSum(data + offset, size) == ::CheckSum(reader));
+				return;
+			}
+		}
+	}
+	// carries
+	memset(data, 0xFF, sizeof(data));
+	PacketReader reader(data, sizeof(data));
+	CHECK(RTMFP::CheckSum(data, sizeof(data)) == ::CheckSum(reader));
+	memset(data, 0, sizeof(data));
+	reader.reset();
+	CHECK(RTMFP::CheckSum(data, sizeof(data)) == ::CheckSum(reader) && RTMFP::CheckSum(data, 0) == 0xFFFF);
+
+	Stopwatch stopwatch;
+	stopwatch.start();
+	UInt32 sum(0);
+	for (UInt32 i = 0; i < PACKETS; ++i)
+		sum += RTMFP::CheckSum(data, RTMFP_MAX_PACKET_SIZE);
+	stopwatch.stop();
+	Int64 elapsed(stopwatch.elapsed());
+	stopwatch.restart();
+	for (UInt32 i = 0; i < PACKETS; ++i) {
+		reader.reset();
+		sum -= ::CheckSum(reader);
+	}
+	stopwatch.stop();
+	CHECK(sum == 0);
+	NOTE("RTMFP checksum ", elapsed, "us, by 16-bit reads ", stopwatch.elapsed(), "us (", PACKETS, " packets of ", RTMFP_MAX_PACKET_SIZE, " bytes)");
+}
+
+ADD_TEST(RTMFPTest, Performance) {
+	shared_ptr<RTMFPKey> pEncryptKey(new RTMFPKey(Key)), pDecryptKey(new RTMFPKey(Key));
+	RTMFPEngine encoder(pEncryptKey, RTMFPEngine::ENCRYPT), decoder(pDecryptKey, RTMFPEngine::DECRYPT);
+	PoolBuffers poolBuffers;
+	PacketWriter packet(poolBuffers);
+	packet.next(RTMFP_HEADER_SIZE);
+	UInt8 payload[PAYLOAD];
+	memset(payload, 0xAB, sizeof(payload));
+
+	Stopwatch stopwatch;
+	stopwatch.start();
+	for (UInt32 i = 0; i < PACKETS; ++i) {
+		packet.clear(RTMFP_HEADER_SIZE);
+		packet.writeRaw(payload, sizeof(payload));
+		RTMFP::Encode(encoder, packet);
+	}
+	stopwatch.stop();
+	Int64 encoding(stopwatch.elapsed());
+
+	Buffer buffer(packet.size());
+	bool decoded(true);
+	Exception ex;
+	stopwatch.restart();
+	for (UInt32 i = 0; i < PACKETS; ++i) {
+		memcpy(buffer.data(), packet.data(), packet.size());
+		PacketReader reader(buffer.data(), buffer.size());
+		reader.next(4);
+		decoded &= RTMFP::Decode(ex, decoder, reader);
+	}
+	stopwatch.stop();
+	CHECK(decoded && !ex && memcmp(buffer.data() + RTMFP_HEADER_SIZE, payload, sizeof(payload)) == 0);
+	NOTE("RTMFP encode ", PACKETS * 1000000ll / (encoding ? encoding : 1), " packets/s, decode ", PACKETS * 1000000ll / (stopwatch.elapsed() ? stopwatch.elapsed() : 1), " packets/s (", packet.size(), " bytes, one core)");
+}
+
+ADD_TEST(RTMFPTest, Congestion) {
+	RTMFPCongestion congestion;
+	deque<pair<Int64, UInt32>> flight;
+	Int64 now(1000000);
+	CHECK(congestion.delay(now) == 0 && congestion.inFlight() == 0);
+
+	// slow start
+	UInt32 window(congestion.window());
+	CHECK(Transmit(congestion, now, 6 * RTT, flight) == 6 * RTT);
+	CHECK(congestion.window() > 4 * window);
+
+	// loss, decreases one time by round-trip
+	window = congestion.window();
+	congestion.lost(now);
+	CHECK(congestion.window() < window && congestion.window() >= UInt32(window * 0.7) - 1);
+	UInt32 decreased(congestion.window());
+	congestion.lost(now + RTT / 2);
+	CHECK(congestion.window() == decreased);
+
+	// congestion avoidance, comes back to the window before the loss then grows beyond
+	CHECK(Transmit(congestion, now, 10000, flight) == 10000);
+	CHECK(congestion.window() > window);
+
+	// nothing acknowledged, the flight is considered lost after the timeout and the window restarts from the minimum
+	CHECK(Transmit(congestion, now, 1500, flight, false) == 1500);
+	CHECK(congestion.window() == 2 * RTMFP_MAX_PACKET_SIZE && congestion.inFlight() <= congestion.window() + PAYLOAD);
+	NOTE("RTMFP congestion window ", window, " bytes before the loss, pacing rate ", (UInt32)congestion.rate(), " bytes/s after the timeout");
+}
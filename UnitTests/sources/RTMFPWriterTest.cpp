@@ -0,0 +1,186 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+#include "Test.h"
+#include "Mona/RTMFP/RTMFPWriter.h"
+#include "Mona/RTMFP/RTMFP.h"
+#include "Mona/StopWatch.h"
+#include "Mona/Logs.h"
+#include <algorithm>
+
+using namespace Mona;
+using namespace std;
+
+#define MESSAGES	10000
+#define LOST_EVERY	97 // one stage lost on LOST_EVERY
+#define ACK_EVERY	4 // the receiver acknowledges every ACK_EVERY stages received
+
+// band which just counts the packets and keeps their content, writer's messages and repetitions are checked by the acknowledgments replayed
+class Band : public BandWriter, virtual Object {
+public:
+	Band(UInt32 window = 16 * 1024 * 1024) : _congestion(window), _packet(_poolBuffers), _pLastWriter(NULL), messages(0), packets(0) { _packet.clear(RTMFP_HEADER_SIZE); }
+	virtual ~Band() { _pWriter.reset(); }
+
+	RTMFPWriter&	writer() { return *_pWriter; }
+	RTMFPCongestion& congestion() { return _congestion; }
+
+	UInt32			messages;
+	UInt32			packets;
+	std::string		content;
+
+private:
+	const PoolBuffers&				poolBuffers() { return _poolBuffers; }
+	void							initWriter(const shared_ptr<RTMFPWriter>& pWriter) { (UInt64&)pWriter->id = 2; _pWriter = pWriter; }
+	shared_ptr<RTMFPWriter>			changeWriter(RTMFPWriter& writer) { shared_ptr<RTMFPWriter> pWriter(_pWriter); _pWriter.reset(&writer); return pWriter; }
+	void							close() {}
+	Timers&							timers() { return _timers; }
+	UInt16							ping() { return 50; }
+	void							manageWriter(RTMFPWriter& writer) {}
+
+	bool							failed() const { return false; }
+	bool							canWriteFollowing(RTMFPWriter& writer) { return _pLastWriter == &writer; }
+	UInt32							availableToWrite() { return RTMFP_MAX_PACKET_SIZE - _packet.size(); }
+	BinaryWriter&					writeMessage(UInt8 type, UInt16 length, RTMFPWriter* pWriter = NULL) {
+		if ((length + 3u) > availableToWrite())
+			flush(false);
+		_pLastWriter = pWriter;
+		++messages;
+		return _packet.write8(type).write16(length);
+	}
+	void							flush(bool full = true) {
+		_pLastWriter = NULL;
+		if (_packet.size() <= RTMFP_HEADER_SIZE)
+			return;
+		++packets;
+		content.append((const char*)_packet.data() + RTMFP_HEADER_SIZE, _packet.size() - RTMFP_HEADER_SIZE);
+		_packet.clear(RTMFP_HEADER_SIZE);
+	}
+
+	PoolBuffers						_poolBuffers;
+	Timers							_timers;
+	RTMFPCongestion					_congestion;
+	PacketWriter					_packet;
+	RTMFPWriter*					_pLastWriter;
+	shared_ptr<RTMFPWriter>			_pWriter; // last, deleted first
+};
+
+// acknowledgment like sent by the receiver when it has received everything until the stage received except the stages lost (every LOST_EVERY)
+static void WriteAck(BinaryWriter& writer, UInt64 received, bool repaired) {
+	writer.write7BitLongValue(0x7F); // buffer size
+	if (!repaired && (received % LOST_EVERY) == 0)
+		--received; // the last stage received can't be a lost one
+	UInt64 stage(repaired ? received : min(received, LOST_EVERY - 1ull));
+	writer.write7BitLongValue(stage); // cumulative acknowledgment
+	while (stage < received) {
+		// 1 lost, and the received ones until the next lost
+		UInt64 next(stage + 1 + LOST_EVERY);
+		writer.write7BitLongValue(0);
+		writer.write7BitLongValue(min(next - 1, received) - stage - 2);
+		stage = min(next - 1, received);
+	}
+}
+
+// returns the number of fragments sent (a message can be fragmented between two packets)
+static UInt64 Send(Band& band, UInt32 count) {
+	UInt8 data[100];
+	memset(data, 0xAB, sizeof(data));
+	for (UInt32 i = 0; i < count; ++i)
+		band.writer().writeRaw(data, sizeof(data)); // reliable
+	// paced, can take some ms: waits the pacing before each flush, then everything is sent when a flush sends nothing more
+	UInt64 stage;
+	do {
+		stage = band.writer().stage();
+		while (band.congestion().delay(Timers::Now()));
+		band.writer().flush(true);
+	} while (band.writer().stage() != stage);
+	return stage;
+}
+
+static UInt32 Replay(Band& band, UInt64 stages, UInt32 ackEvery, Int64& elapsed) {
+	PoolBuffers poolBuffers;
+	PacketWriter packet(poolBuffers);
+	Stopwatch stopwatch;
+	UInt32 messages(band.messages);
+	for (UInt64 received = ackEvery; received <= stages; received += ackEvery) {
+		packet.clear();
+		WriteAck(packet, received, false);
+		PacketReader reader(packet.data(), packet.size());
+		stopwatch.start();
+		band.writer().acknowledgment(reader);
+		stopwatch.stop();
+	}
+	packet.clear();
+	WriteAck(packet, stages, true);
+	PacketReader reader(packet.data(), packet.size());
+	stopwatch.start();
+	band.writer().acknowledgment(reader);
+	stopwatch.stop();
+	elapsed = stopwatch.elapsed();
+	return band.messages - messages; // repetitions
+}
+
+ADD_TEST(RTMFPWriterTest, Acknowledgment) {
+	Band band;
+	shared_ptr<RTMFPWriter> pWriter;
+	new RTMFPWriter("test", band, pWriter);
+	pWriter.reset();
+
+	UInt64 stages(Send(band, 2 * LOST_EVERY));
+	CHECK(stages >= 2 * LOST_EVERY && band.congestion().inFlight() >= 2 * LOST_EVERY * 100);
+
+	// the stages lost are repeated once (a stage is repeated again just when the receiver has got the stage of its repetition)
+	Int64 elapsed;
+	CHECK(Replay(band, stages, 1, elapsed) == stages / LOST_EVERY);
+	CHECK(band.congestion().inFlight() == 0);
+}
+
+ADD_TEST(RTMFPWriterTest, Unreliable) {
+	Band band(2 * RTMFP_MAX_PACKET_SIZE); // slow pacing
+	shared_ptr<RTMFPWriter> pWriter;
+	new RTMFPWriter("test", band, pWriter);
+	pWriter.reset();
+	band.writer().reliable = false;
+
+	// the second message waits the pacing, its data must be copied because released by the caller after the writeRaw call
+	UInt8 data[1000];
+	memset(data, 0xAB, sizeof(data));
+	band.writer().writeRaw(data, sizeof(data));
+	band.writer().writeRaw(data, sizeof(data));
+	memset(data, 0, sizeof(data));
+
+	Send(band, 0);
+	CHECK(band.congestion().inFlight() == 2 * sizeof(data));
+	CHECK(count(band.content.begin(), band.content.end(), '\xAB') == 2 * sizeof(data));
+}
+
+ADD_TEST(RTMFPWriterTest, Performance) {
+	Band band;
+	shared_ptr<RTMFPWriter> pWriter;
+	new RTMFPWriter("test", band, pWriter);
+	pWriter.reset();
+
+	UInt64 stages(Send(band, MESSAGES));
+	CHECK(stages >= MESSAGES && band.congestion().inFlight() >= MESSAGES * 100);
+
+	// all the fragments are outstanding, replays the acknowledgments of the receiver
+	Int64 elapsed;
+	CHECK(Replay(band, stages, ACK_EVERY, elapsed) == stages / LOST_EVERY);
+	CHECK(band.congestion().inFlight() == 0);
+	NOTE("RTMFPWriter ", stages / ACK_EVERY + 1, " acknowledgments of ", stages, " fragments outstanding with 1 lost on ", LOST_EVERY, " replayed in ", elapsed, "us");
+}
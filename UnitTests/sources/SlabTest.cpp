@@ -0,0 +1,98 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+#include "Test.h"
+#include "Mona/Slab.h"
+#include "Mona/StopWatch.h"
+#include "Mona/Logs.h"
+#include <deque>
+#include <thread>
+
+using namespace Mona;
+using namespace std;
+
+#define MESSAGES	200000
+#define WINDOW		64
+
+ADD_TEST(SlabTest, Blocks) {
+	Slab slab(10, 4);
+	CHECK(slab.blockSize() == 16 && slab.blocks() == 0 && slab.used() == 0);
+
+	void* pBlocks[5];
+	for (UInt8 i = 0; i < 5; ++i)
+		pBlocks[i] = slab.allocate();
+	CHECK(slab.blocks() == 8 && slab.used() == 5);
+	for (UInt8 i = 1; i < 5; ++i)
+		CHECK(pBlocks[i] != pBlocks[i - 1] && ((size_t)pBlocks[i] & 15) == 0);
+
+	// a released block is reused first
+	slab.release(pBlocks[2]);
+	CHECK(slab.used() == 4 && slab.allocate() == pBlocks[2]);
+	for (UInt8 i = 0; i < 5; ++i)
+		slab.release(pBlocks[i]);
+	CHECK(slab.used() == 0 && slab.blocks() == 8);
+}
+
+ADD_TEST(SlabTest, Threads) {
+	Slab slab(100);
+	vector<thread> threads;
+	for (UInt8 i = 0; i < 4; ++i) {
+		threads.emplace_back([&slab]() {
+			for (UInt32 j = 0; j < 10000; ++j)
+				slab.release(slab.allocate());
+		});
+	}
+	for (thread& thread : threads)
+		thread.join();
+	CHECK(slab.used() == 0 && slab.blocks() <= 4 * 64);
+}
+
+ADD_TEST(SlabTest, Window) {
+	// a window of messages sent and acknowledged, as a RTMFP writer: the slab stays on 2 chunks
+	Slab slab(256);
+	deque<void*> slabWindow, heapWindow;
+	Stopwatch slabWatch, heapWatch;
+
+	slabWatch.start();
+	for (UInt32 i = 0; i < MESSAGES; ++i) {
+		slabWindow.emplace_back(slab.allocate());
+		if (slabWindow.size() > WINDOW) {
+			slab.release(slabWindow.front());
+			slabWindow.pop_front();
+		}
+	}
+	slabWatch.stop();
+
+	heapWatch.start();
+	for (UInt32 i = 0; i < MESSAGES; ++i) {
+		heapWindow.emplace_back(::operator new(256));
+		if (heapWindow.size() > WINDOW) {
+			::operator delete(heapWindow.front());
+			heapWindow.pop_front();
+		}
+	}
+	heapWatch.stop();
+
+	CHECK(slab.blocks() == 128); // WINDOW+1 blocks
+	for (void* pBlock : slabWindow)
+		slab.release(pBlock);
+	for (void* pBlock : heapWindow)
+		::operator delete(pBlock);
+	NOTE("Slab ", slabWatch.elapsed(), "us, heap ", heapWatch.elapsed(), "us (", MESSAGES, " messages)");
+}
@@ -0,0 +1,265 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+#include "Test.h"
+#include "Mona/TCPServer.h"
+#include "Mona/TCPClient.h"
+#include "Mona/TCPVectorSender.h"
+#include "Mona/ServerSocket.h"
+#include "Mona/SocketManager.h"
+#include "Mona/Logs.h"
+#include "Mona/Event.h"
+#include <atomic>
+#include <thread>
+
+using namespace Mona;
+using namespace std;
+
+#define MESSAGE_SIZE	100
+#define MESSAGES		2000
+#define QUEUE_SIZE		1048576
+
+// Consumes only complete messages, to check the rest kept between reads
+class TCPReceiver : public TCPClient, virtual Object {
+public:
+	TCPReceiver(const SocketAddress& peerAddress, const SocketManager& manager) : TCPClient(peerAddress, manager), received(0), disconnected(false) {}
+
+	atomic<UInt32>	received;
+	atomic<bool>	disconnected;
+	Event			complete;
+private:
+	UInt32 onReception(const UInt8* data, UInt32 size) {
+		UInt32 rest(size % MESSAGE_SIZE);
+		for (UInt32 i = 0; i < size - rest; i += MESSAGE_SIZE) {
+			if (data[i] != (UInt8)(received % 256))
+				return size; // corrupted, stop the consumption
+			++received;
+		}
+		if (received == MESSAGES)
+			complete.set();
+		return rest;
+	}
+	void onDisconnection() {
+		disconnected = true;
+		complete.set();
+	}
+	void onError(const string& error) { DEBUG("TCPReceiver, ", error); }
+};
+
+class TCPListener : public TCPServer, virtual Object {
+public:
+	TCPListener(const SocketManager& manager) : TCPServer(manager), pReceiver(NULL), _manager(manager) {}
+	~TCPListener() { if (pReceiver) delete pReceiver; }
+
+	TCPReceiver*	pReceiver;
+	Event			accepted;
+private:
+	void onConnectionRequest(Exception& ex) {
+		TCPReceiver* pClient = acceptClient<TCPReceiver>(ex, _manager);
+		if (!pClient)
+			return;
+		pReceiver = pClient;
+		accepted.set();
+	}
+	void onError(const string& error) { DEBUG("TCPListener, ", error); }
+
+	const SocketManager& _manager;
+};
+
+class TCPEmitter : public TCPClient, virtual Object {
+public:
+	TCPEmitter(const SocketManager& manager) : TCPClient(manager), blocked(0), drained(0) {}
+
+	atomic<UInt32>	blocked;
+	atomic<UInt32>	drained;
+private:
+	UInt32	onReception(const UInt8* data, UInt32 size) { return 0; }
+	void	onError(const string& error) { DEBUG("TCPEmitter, ", error); }
+	void	onWriteBlocked() { ++blocked; }
+	void	onWriteDrained() { ++drained; }
+};
+
+// Not managed sockets, the accepted connection is read in a blocking way by the test itself
+class TCPPeer : public StreamSocket, virtual Object {
+public:
+	TCPPeer(const SocketAddress& address, const SocketManager& manager) : StreamSocket(manager) {}
+private:
+	void onError(const string& error) { DEBUG("TCPPeer, ", error); }
+	void onReadable(Exception& ex) {}
+};
+
+class TCPAcceptor : public ServerSocket, virtual Object {
+public:
+	TCPAcceptor(const SocketManager& manager) : ServerSocket(manager) {}
+private:
+	void onError(const string& error) { DEBUG("TCPAcceptor, ", error); }
+	void onReadable(Exception& ex) {}
+};
+
+// Messages alternatively written in its buffer and referenced in a shared block
+class GatherSender : public TCPVectorSender, virtual Object {
+public:
+	GatherSender(const shared_ptr<Buffer>& pMessages) : TCPVectorSender("GatherSender") {
+		for (UInt32 i = 0; i < MESSAGES; ++i) {
+			if (i & 1) {
+				reference(pMessages, pMessages->data() + i*MESSAGE_SIZE, MESSAGE_SIZE);
+				continue;
+			}
+			UInt32 size(_buffer.size());
+			_buffer.resize(size + MESSAGE_SIZE, true);
+			memset(_buffer.data() + size, i % 256, MESSAGE_SIZE);
+		}
+	}
+	const UInt8*	data() { return _buffer.data(); }
+	UInt32			size() { return _buffer.size(); }
+private:
+	Buffer	_buffer;
+};
+
+static void Reception(bool edgeTriggered) {
+	PoolBuffers poolBuffers;
+	PoolThreads poolThreads(1);
+	SocketManager sockets(poolBuffers, poolThreads);
+	Exception ex;
+	CHECK(sockets.setEdgeTriggered(edgeTriggered) && sockets.start(ex) && !ex);
+
+	TCPListener listener(sockets);
+	SocketAddress address;
+	CHECK(address.set(ex, "127.0.0.1", 0) && listener.start(ex, address));
+	Exception exAddress;
+	listener.socket().address(exAddress, address);
+	CHECK(!exAddress);
+
+	unique_ptr<TCPEmitter> pSender(new TCPEmitter(sockets));
+	CHECK(pSender->connect(ex, address) && !ex);
+	CHECK(listener.accepted.wait(3000) && listener.pReceiver);
+
+	// messages by chunks which don't match the message size, and bigger than the reading buffer
+	UInt8 data[MESSAGE_SIZE*MESSAGES];
+	for (UInt32 i = 0; i < MESSAGES; ++i)
+		memset(data + i*MESSAGE_SIZE, i % 256, MESSAGE_SIZE);
+	UInt32 sent(0);
+	while (sent < sizeof(data)) {
+		UInt32 size(min<UInt32>(sizeof(data) - sent, 7777));
+		CHECK(pSender->send(ex, data + sent, size) && !ex);
+		sent += size;
+	}
+	CHECK(listener.pReceiver->complete.wait(3000) && listener.pReceiver->received == MESSAGES);
+
+	// end of stream (the socket is closed on deletion)
+	pSender.reset();
+	CHECK(listener.pReceiver->complete.wait(3000) && listener.pReceiver->disconnected);
+
+	listener.stop();
+	sockets.stop();
+}
+
+ADD_TEST(TCPClientTest, Reception) {
+	Reception(false);
+}
+
+ADD_TEST(TCPClientTest, EdgeTriggered) {
+#if !defined(_WIN32)
+	Reception(true);
+#endif
+}
+
+ADD_TEST(TCPClientTest, Gather) {
+	PoolBuffers poolBuffers;
+	PoolThreads poolThreads(1);
+	SocketManager sockets(poolBuffers, poolThreads);
+	Exception ex;
+	CHECK(sockets.start(ex) && !ex);
+
+	TCPListener listener(sockets);
+	SocketAddress address;
+	CHECK(address.set(ex, "127.0.0.1", 0) && listener.start(ex, address));
+	Exception exAddress;
+	listener.socket().address(exAddress, address);
+	CHECK(!exAddress);
+
+	TCPEmitter emitter(sockets);
+	CHECK(emitter.connect(ex, address) && !ex);
+	CHECK(listener.accepted.wait(3000) && listener.pReceiver);
+
+	shared_ptr<Buffer> pMessages(new Buffer(MESSAGE_SIZE*MESSAGES));
+	for (UInt32 i = 0; i < MESSAGES; ++i)
+		memset(pMessages->data() + i*MESSAGE_SIZE, i % 256, MESSAGE_SIZE);
+	// small socket buffer to resume the sending in the middle of parts
+	emitter.socket().setSendBufferSize(ex, 4096);
+	CHECK(!ex);
+	shared_ptr<GatherSender> pSender(new GatherSender(pMessages));
+	CHECK(emitter.send<GatherSender>(ex, pSender) && !ex);
+	CHECK(listener.pReceiver->complete.wait(3000) && listener.pReceiver->received == MESSAGES);
+
+	listener.stop();
+	sockets.stop();
+}
+
+ADD_TEST(TCPClientTest, Queue) {
+	PoolBuffers poolBuffers;
+	PoolThreads poolThreads(1);
+	SocketManager sockets(poolBuffers, poolThreads);
+	Exception ex;
+	CHECK(sockets.start(ex) && !ex);
+
+	// the connection is read only when the queue is full
+	TCPAcceptor server(sockets);
+	SocketAddress address;
+	CHECK(address.set(ex, "127.0.0.1", 0) && server.bind(ex, address) && server.listen(ex) && !ex);
+	server.address(ex, address);
+	CHECK(!ex);
+
+	TCPEmitter emitter(sockets);
+	CHECK(emitter.connect(ex, address) && !ex);
+	unique_ptr<TCPPeer> pPeer(server.acceptConnection<TCPPeer>(ex, sockets));
+	CHECK(pPeer && !ex);
+	emitter.socket().setSendBufferSize(ex, 4096);
+	emitter.socket().setQueueMaximum(65536);
+	CHECK(!ex && !emitter.socket().congested());
+
+	// the pool buffer is given to the sender without copy, then data are copied (in a pool buffer) when queued
+	PoolBuffer pBuffer(poolBuffers, QUEUE_SIZE);
+	for (UInt32 i = 0; i < QUEUE_SIZE; ++i)
+		pBuffer->data()[i] = (UInt8)i;
+	Buffer data(QUEUE_SIZE);
+	memcpy(data.data(), pBuffer->data(), QUEUE_SIZE);
+	CHECK(emitter.send(ex, pBuffer) && !ex && pBuffer.empty());
+	CHECK(emitter.socket().queueing() > 0 && emitter.socket().queueing() <= QUEUE_SIZE && emitter.socket().congested() && emitter.blocked == 1);
+	CHECK(emitter.send(ex, data.data(), QUEUE_SIZE) && !ex);
+	memset(data.data(), 0, QUEUE_SIZE); // sent data have been retained
+	CHECK(emitter.socket().queueing() > QUEUE_SIZE);
+
+	// drain the connection
+	UInt32 received(0);
+	while (received < 2 * QUEUE_SIZE) {
+		int count(pPeer->receiveBytes(ex, data.data(), min<UInt32>(QUEUE_SIZE, 2 * QUEUE_SIZE - received)));
+		CHECK(count > 0 && !ex);
+		for (int i = 0; i < count; ++i)
+			CHECK(data.data()[i] == (UInt8)((received + i) % QUEUE_SIZE));
+		received += count;
+	}
+	UInt32 elapsed(0);
+	while (emitter.socket().queueing() > 0 && elapsed++ < 3000)
+		this_thread::sleep_for(chrono::milliseconds(1));
+	CHECK(emitter.socket().queueing() == 0 && !emitter.socket().congested());
+	// notified just one time thanks to the hysteresis
+	CHECK(emitter.blocked == 1 && emitter.drained == 1);
+
+	sockets.stop();
+}
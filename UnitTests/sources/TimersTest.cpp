@@ -0,0 +1,123 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+
+#include "Test.h"
+#include "Mona/Timers.h"
+#include "Mona/StopWatch.h"
+#include "Mona/Logs.h"
+#include <vector>
+
+using namespace Mona;
+using namespace std;
+
+#define TIMERS	100000
+
+class TestTimer : public Timers::Timer {
+public:
+	TestTimer(UInt32 repeat = 0) : raised(0), time(0), repeat(repeat), pCancel(NULL) {}
+	UInt32		raised;
+	Int64		time;
+	UInt32		repeat;
+	Timer*		pCancel;
+private:
+	UInt32 onTimer(Int64 now) {
+		++raised;
+		time = now;
+		if (pCancel)
+			pCancel->cancel();
+		return repeat;
+	}
+};
+
+ADD_TEST(TimersTest, Expiration) {
+	Timers timers;
+	Int64 now(Timers::Now());
+	static const UInt32 Delays[] = { 1, 5, 255, 256, 257, 300, 65535, 65536, 70000, 20000000 };
+	vector<TestTimer> list(sizeof(Delays) / sizeof(UInt32));
+	for (UInt32 i = 0; i < list.size(); ++i)
+		timers.set(list[i], now, Delays[i]);
+	CHECK(timers.count() == list.size());
+
+	// raised exactly at their expiration, with a raise by ms
+	for (Int64 time = now; time <= now + 70000; ++time)
+		timers.raise(time);
+	for (UInt32 i = 0; i < list.size() - 1; ++i)
+		CHECK(list[i].raised == 1 && list[i].time == now + Delays[i] && !list[i].active());
+	CHECK(list.back().raised == 0 && list.back().active() && timers.count() == 1);
+
+	// raised late if raise is called late
+	CHECK(timers.raise(now + 30000000) == 0 && list.back().raised == 1 && list.back().time == now + 30000000 && timers.count() == 0);
+}
+
+ADD_TEST(TimersTest, Repeat) {
+	Timers timers;
+	Int64 now(Timers::Now());
+	TestTimer repeated(100), canceled, canceler;
+	timers.set(repeated, now, 100);
+	timers.set(canceled, now, 50);
+	timers.set(canceler, now, 10);
+	canceler.pCancel = &canceled;
+
+	// delay before the next due
+	CHECK(timers.raise(now) == 10);
+	CHECK(timers.raise(now + 10) == 90 && canceler.raised == 1 && !canceled.active());
+	CHECK(timers.raise(now + 1000) == 100 && repeated.raised == 1 && repeated.expiration() == now + 1100);
+	CHECK(timers.raise(now + 1100) == 100 && repeated.raised == 2 && canceled.raised == 0);
+
+	// set again, and destruction of an active timer
+	timers.set(repeated, now + 1100, 5);
+	CHECK(repeated.expiration() == now + 1105);
+	{
+		TestTimer temporary;
+		timers.set(temporary, now + 1100, 1);
+	}
+	CHECK(timers.count() == 1 && timers.raise(now + 1105) == 100 && repeated.raised == 3);
+	repeated.cancel();
+	CHECK(timers.count() == 0 && timers.raise(now + 2000) == 0);
+}
+
+ADD_TEST(TimersTest, Performance) {
+	Timers timers;
+	Int64 now(Timers::Now());
+	vector<TestTimer> list(TIMERS);
+	Stopwatch stopwatch;
+	stopwatch.start();
+	// timers of writers and sessions, most of them are reset before to be due
+	for (UInt32 i = 0; i < TIMERS; ++i)
+		timers.set(list[i], now, 1000 + i % 120000);
+	for (UInt32 i = 0; i < TIMERS; i += 2)
+		timers.set(list[i], now + 500, 1000 + i % 120000);
+	stopwatch.stop();
+	Int64 setting(stopwatch.elapsed());
+
+	// 10 seconds, raised every 10ms
+	stopwatch.restart();
+	UInt32 raised(0);
+	for (Int64 time = now; time <= now + 10000; time += 10)
+		timers.raise(time);
+	stopwatch.stop();
+	bool exact(true);
+	for (TestTimer& timer : list) {
+		raised += timer.raised;
+		exact &= (timer.raised == 1) == (timer.expiration() <= now + 10000);
+	}
+	CHECK(exact && raised == 8751 && timers.count() == TIMERS - raised);
+	NOTE("Timers ", setting, "us to set ", TIMERS + TIMERS / 2, " timers, ", stopwatch.elapsed(), "us to raise ", raised, " of them on 10 seconds");
+}
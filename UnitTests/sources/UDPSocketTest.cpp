@@ -0,0 +1,208 @@
+/*
+Copyright 2014 Mona
+mathieu.poux[a]gmail.com
+jammetthomas[a]gmail.com
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License received along this program for more
+details (or else see http://www.gnu.org/licenses/).
+
+This file is a part of Mona.
+*/
+
+#include "Test.h"
+#include "Mona/UDPSocket.h"
+#include "Mona/UDPSender.h"
+#include "Mona/SocketManager.h"
+#include "Mona/TaskHandler.h"
+#include "Mona/Logs.h"
+#include "Mona/Event.h"
+#include <atomic>
+
+using namespace Mona;
+using namespace std;
+
+#define BURSTS		300
+#define BURST		64 // datagrams by burst, fits in the receiver buffer to avoid loopback drops
+#define PACKET_SIZE	1000
+
+class UDPReceiver : public UDPSocket, virtual Object {
+public:
+	UDPReceiver(const SocketManager& manager) : UDPSocket(manager), received(0), bytes(0), expected(0) {}
+
+	atomic<UInt32>	received;
+	atomic<UInt32>	bytes;
+	atomic<UInt32>	expected;
+	Event			complete;
+private:
+	void onReception(const UInt8* data, UInt32 size, const SocketAddress& address) {
+		bytes += size;
+		if (++received == expected)
+			complete.set();
+	}
+	void onError(const string& error) { DEBUG("UDPReceiver, ", error); }
+};
+
+// Read by its reactor thread, even with a SocketManager which posts its events to a handler
+class ReactorReceiver : public UDPReceiver, virtual Object {
+public:
+	ReactorReceiver(const SocketManager& manager) : UDPReceiver(manager) {}
+private:
+	bool readsInReactor() const { return true; }
+};
+
+// Handler which never handles the tasks posted, as a busy server thread
+class BusyHandler : public TaskHandler, virtual Object {
+public:
+	BusyHandler() { start(); }
+private:
+	void requestHandle() {}
+};
+
+// Blocks its PoolThread until opened, to queue a burst of datagrams behind it as on a loaded server
+class Gate : public WorkThread, virtual Object {
+public:
+	Gate() : WorkThread("Gate") {}
+	Event	opened;
+private:
+	bool run(Exception& ex) {
+		opened.wait();
+		return true;
+	}
+};
+
+// Sends bursts of datagrams on loopback (by a PoolThread, as RTMFP) and returns the number of packets received by second
+static UInt32 Bench(UInt16 batch, bool offload = false, bool edgeTriggered = false) {
+	PoolBuffers poolBuffers;
+	PoolThreads poolThreads(1);
+	SocketManager sockets(poolBuffers, poolThreads);
+	Exception ex;
+	CHECK(sockets.setEdgeTriggered(edgeTriggered) && sockets.start(ex) && !ex);
+
+	UDPReceiver receiver(sockets), sender(sockets);
+	receiver.setBatch(batch);
+	sender.setBatch(batch);
+	SocketAddress address;
+	CHECK(address.set(ex, "127.0.0.1", 0));
+	CHECK(receiver.bind(ex, address) && sender.bind(ex, address));
+	if (offload && !(sender.setGSO(true) && receiver.setGRO(true)))
+		NOTE("UDPSocket offloads unsupported");
+	address.set(ex, "127.0.0.1", receiver.address().port());
+	CHECK(!ex);
+
+	UInt8 packet[PACKET_SIZE];
+	memset(packet, 'x', sizeof(packet));
+	Stopwatch stopwatch;
+	stopwatch.start();
+	PoolThread* pThread(NULL);
+	for (UInt32 i = 0; i < BURSTS; ++i) {
+		shared_ptr<Gate> pGate(new Gate());
+		pThread = poolThreads.enqueue<Gate>(ex, pGate, pThread);
+		for (UInt32 j = 0; j < BURST; ++j) {
+			shared_ptr<UDPSender> pSender(new UDPSender("UDPSocketTest", packet, sizeof(packet)));
+			pSender->address.set(address);
+			pThread = sender.send<UDPSender>(ex, pSender, pThread);
+		}
+		receiver.expected = (i + 1)*BURST;
+		pGate->opened.set();
+		receiver.complete.wait(100); // wait the reception of the burst
+	}
+	stopwatch.stop();
+	CHECK(!ex);
+	poolThreads.join();
+	sockets.stop();
+
+	UInt32 received(receiver.received);
+	CHECK(received > 0 && receiver.bytes == received*PACKET_SIZE); // GRO datagrams split again
+	UInt32 packetsPerSecond = (UInt32)(received*1000000LL / stopwatch.elapsed());
+	NOTE("UDPSocket batch=", batch, offload ? " with GSO/GRO" : "", edgeTriggered ? " edge-triggered" : "", ", ", received, "/", BURSTS*BURST, " packets received, ", packetsPerSecond, " packets/s");
+	return packetsPerSecond;
+}
+
+ADD_TEST(UDPSocketTest, Unbatched) {
+	Bench(0);
+}
+
+ADD_TEST(UDPSocketTest, Batched) {
+	Bench(32);
+}
+
+ADD_TEST(UDPSocketTest, Offloaded) {
+	Bench(32, true);
+}
+
+ADD_TEST(UDPSocketTest, BatchFlush) {
+	PoolBuffers poolBuffers;
+	PoolThreads poolThreads(1);
+	SocketManager sockets(poolBuffers, poolThreads);
+	Exception ex;
+	CHECK(sockets.start(ex) && !ex);
+
+	UDPReceiver receiver(sockets), sender(sockets);
+	sender.setBatch(32);
+	SocketAddress address;
+	CHECK(address.set(ex, "127.0.0.1", 0));
+	CHECK(receiver.bind(ex, address) && sender.bind(ex, address));
+	address.set(ex, "127.0.0.1", receiver.address().port());
+	receiver.expected = 1;
+
+	// a datagram queued in batch mode is sent when its PoolThread runs out of jobs, even if the following jobs don't send
+	UInt8 packet[PACKET_SIZE];
+	memset(packet, 'x', sizeof(packet));
+	shared_ptr<Gate> pGate(new Gate()), pOpenedGate(new Gate());
+	pOpenedGate->opened.set();
+	PoolThread* pThread = poolThreads.enqueue<Gate>(ex, pGate);
+	shared_ptr<UDPSender> pSender(new UDPSender("UDPSocketTest", packet, sizeof(packet)));
+	pSender->address.set(address);
+	pThread = sender.send<UDPSender>(ex, pSender, pThread);
+	poolThreads.enqueue<Gate>(ex, pOpenedGate, pThread);
+	pGate->opened.set();
+	CHECK(!ex && receiver.complete.wait(1000));
+
+	poolThreads.join();
+	sockets.stop();
+}
+
+ADD_TEST(UDPSocketTest, ReadsInReactor) {
+	PoolBuffers poolBuffers;
+	PoolThreads poolThreads(1);
+	BusyHandler handler;
+	SocketManager sockets(handler, poolBuffers, poolThreads);
+	Exception ex;
+	CHECK(sockets.start(ex) && !ex);
+
+	ReactorReceiver receiver(sockets);
+	UDPReceiver sender(sockets);
+	SocketAddress address;
+	CHECK(address.set(ex, "127.0.0.1", 0));
+	CHECK(receiver.bind(ex, address) && sender.bind(ex, address));
+	address.set(ex, "127.0.0.1", receiver.address().port());
+
+	// received without the handler thread, several times to check the rearming
+	UInt8 packet[PACKET_SIZE];
+	memset(packet, 'x', sizeof(packet));
+	for (UInt32 i = 1; i <= 3; ++i) {
+		receiver.expected = i;
+		CHECK(sender.send(ex, packet, sizeof(packet), address) && !ex);
+		CHECK(receiver.complete.wait(1000));
+	}
+	// close waits the end of a reading in progress
+	receiver.close();
+
+	poolThreads.join();
+	sockets.stop();
+}
+
+ADD_TEST(UDPSocketTest, EdgeTriggered) {
+#if !defined(_WIN32)
+	Bench(0, false, true);
+	Bench(32, false, true);
+#endif
+}